@@ -0,0 +1,378 @@
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <wlr/types/wlr_keyboard.h>
+#include "sway/config.h"
+#include "sway/input/keyboard.h"
+#include "list.h"
+#include "log.h"
+
+// Replays a synthetic key event trace against a large binding set, looking
+// up each event both through the binding index and with the linear scan the
+// index replaced. The two must pick the same binding for every event.
+
+#define KEY_POOL 256
+#define BATCH 32
+
+static const char *bench_input = "1:1:scroll-bench-keyboard";
+
+// Written after every lookup so the timed loops can't be optimized out
+static struct sway_binding *volatile bench_sink;
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15;
+
+static uint32_t rng_next(void) {
+	// xorshift64*
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return (rng_state * 0x2545f4914f6cdd1dull) >> 32;
+}
+
+static bool rng_chance(int percent) {
+	return rng_next() % 100 < (uint32_t)percent;
+}
+
+static uint32_t random_key(void) {
+	// Printable keysyms followed by the function keys
+	uint32_t i = rng_next() % KEY_POOL;
+	return i < 0x5f ? 0x20 + i : 0xffbe + (i - 0x5f);
+}
+
+static uint32_t random_modifiers(void) {
+	static const uint32_t mods[] = {
+		WLR_MODIFIER_SHIFT, WLR_MODIFIER_CTRL,
+		WLR_MODIFIER_ALT, WLR_MODIFIER_LOGO,
+	};
+	uint32_t modifiers = 0;
+	for (size_t i = 0; i < sizeof(mods) / sizeof(mods[0]); ++i) {
+		if (rng_chance(40)) {
+			modifiers |= mods[i];
+		}
+	}
+	return modifiers;
+}
+
+static int key_cmp(const void *a, const void *b) {
+	uint32_t key_a = **(uint32_t **)a, key_b = **(uint32_t **)b;
+	return key_a < key_b ? -1 : key_a > key_b;
+}
+
+static void add_key(list_t *keys, uint32_t key) {
+	uint32_t *item = malloc(sizeof(uint32_t));
+	*item = key;
+	list_add(keys, item);
+}
+
+static struct sway_binding *random_binding(int order) {
+	struct sway_binding *binding = calloc(1, sizeof(struct sway_binding));
+	binding->type = BINDING_KEYSYM;
+	binding->order = order;
+	binding->input = rng_chance(90) ? "*" : (char *)bench_input;
+	binding->modifiers = random_modifiers();
+	binding->group = rng_chance(90) ? XKB_LAYOUT_INVALID : rng_next() % 2;
+	if (rng_chance(5)) {
+		binding->flags |= BINDING_RELEASE;
+	}
+	if (rng_chance(10)) {
+		binding->flags |= BINDING_LOCKED;
+	}
+	if (rng_chance(5)) {
+		binding->flags |= BINDING_INHIBITED;
+	}
+	binding->keys = create_list();
+	add_key(binding->keys, random_key());
+	if (rng_chance(20)) {
+		uint32_t key;
+		do {
+			key = random_key();
+		} while (key == *(uint32_t *)binding->keys->items[0]);
+		add_key(binding->keys, key);
+		list_qsort(binding->keys, key_cmp);
+	}
+	return binding;
+}
+
+struct key_event {
+	struct sway_shortcut_state state;
+	uint32_t modifiers;
+	bool release;
+	bool locked;
+	xkb_layout_index_t group;
+};
+
+static void random_event(struct key_event *event, list_t *bindings) {
+	memset(event, 0, sizeof(*event));
+	event->locked = rng_chance(5);
+	event->group = rng_next() % 2;
+	struct sway_shortcut_state *state = &event->state;
+	if (rng_chance(50)) {
+		// Press the keys of an existing binding
+		struct sway_binding *binding =
+			bindings->items[rng_next() % bindings->length];
+		for (int i = 0; i < binding->keys->length; ++i) {
+			state->pressed_keys[i] = *(uint32_t *)binding->keys->items[i];
+		}
+		state->npressed = binding->keys->length;
+		state->current_key = state->pressed_keys[rng_next() % state->npressed];
+		event->modifiers = binding->modifiers;
+		event->release = binding->flags & BINDING_RELEASE;
+	} else {
+		state->pressed_keys[0] = random_key();
+		state->npressed = 1;
+		state->current_key = state->pressed_keys[0];
+		event->modifiers = random_modifiers();
+		event->release = rng_chance(5);
+	}
+}
+
+/**
+ * The lookup before the binding index: every binding of the mode is checked.
+ */
+static void linear_get_active(const struct sway_shortcut_state *state,
+		list_t *bindings, struct sway_binding **current_binding,
+		uint32_t modifiers, bool release, bool locked, bool inhibited,
+		const char *input, bool exact_input, xkb_layout_index_t group) {
+	for (int i = 0; i < bindings->length; ++i) {
+		struct sway_binding *binding = bindings->items[i];
+		bool binding_locked = (binding->flags & BINDING_LOCKED) != 0;
+		bool binding_inhibited = (binding->flags & BINDING_INHIBITED) != 0;
+		bool binding_release = binding->flags & BINDING_RELEASE;
+
+		if (modifiers ^ binding->modifiers ||
+				release != binding_release ||
+				locked > binding_locked ||
+				inhibited > binding_inhibited ||
+				(binding->group != XKB_LAYOUT_INVALID &&
+				 binding->group != group) ||
+				(strcmp(binding->input, input) != 0 &&
+				 (strcmp(binding->input, "*") != 0 || exact_input))) {
+			continue;
+		}
+
+		bool match = false;
+		if (state->npressed == (size_t)binding->keys->length) {
+			match = true;
+			for (size_t j = 0; j < state->npressed; j++) {
+				uint32_t key = *(uint32_t *)binding->keys->items[j];
+				if (key != state->pressed_keys[j]) {
+					match = false;
+					break;
+				}
+			}
+		} else if (binding->keys->length == 1) {
+			match = state->current_key == *(uint32_t *)binding->keys->items[0];
+		}
+		if (!match) {
+			continue;
+		}
+
+		if (*current_binding) {
+			if (*current_binding == binding) {
+				continue;
+			}
+
+			bool current_locked =
+				((*current_binding)->flags & BINDING_LOCKED) != 0;
+			bool current_inhibited =
+				((*current_binding)->flags & BINDING_INHIBITED) != 0;
+			bool current_input = strcmp((*current_binding)->input, input) == 0;
+			bool current_group_set =
+				(*current_binding)->group != XKB_LAYOUT_INVALID;
+			bool binding_input = strcmp(binding->input, input) == 0;
+			bool binding_group_set = binding->group != XKB_LAYOUT_INVALID;
+
+			if (current_input == binding_input
+					&& current_locked == binding_locked
+					&& current_inhibited == binding_inhibited
+					&& current_group_set == binding_group_set) {
+				continue;
+			}
+
+			if (current_input && !binding_input) {
+				continue;
+			}
+
+			if (current_input == binding_input &&
+				   (*current_binding)->group == group) {
+				continue;
+			}
+
+			if (current_input == binding_input &&
+					current_group_set == binding_group_set &&
+					current_locked == locked) {
+				continue;
+			}
+
+			if (current_input == binding_input &&
+					current_group_set == binding_group_set &&
+					current_locked == binding_locked &&
+					current_inhibited == inhibited) {
+				continue;
+			}
+		}
+
+		*current_binding = binding;
+		if (strcmp((*current_binding)->input, input) == 0 &&
+				(((*current_binding)->flags & BINDING_LOCKED) == locked) &&
+				(((*current_binding)->flags & BINDING_INHIBITED) == inhibited) &&
+				(*current_binding)->group == group) {
+			return;
+		}
+	}
+}
+
+static int64_t now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int double_cmp(const void *a, const void *b) {
+	double da = *(const double *)a, db = *(const double *)b;
+	return da < db ? -1 : da > db;
+}
+
+static void report(const char *name, double *samples, size_t len) {
+	double total = 0;
+	for (size_t i = 0; i < len; ++i) {
+		total += samples[i];
+	}
+	qsort(samples, len, sizeof(double), double_cmp);
+	printf("%-8s p50 %8.1f ns  p99 %8.1f ns  mean %8.1f ns\n", name,
+		samples[len / 2], samples[len * 99 / 100], total / len);
+}
+
+static const char usage[] =
+	"Usage: binding-lookup [options...]\n"
+	"\n"
+	"  -h, --help              Show help message and quit.\n"
+	"  -b, --bindings <count>  Number of key bindings (default 2000).\n"
+	"  -e, --events <count>    Number of key events (default 200000).\n"
+	"  -s, --seed <seed>       Seed of the binding set and trace.\n";
+
+int main(int argc, char **argv) {
+	int nbindings = 2000;
+	int nevents = 200000;
+
+	static const struct option long_options[] = {
+		{"help", no_argument, NULL, 'h'},
+		{"bindings", required_argument, NULL, 'b'},
+		{"events", required_argument, NULL, 'e'},
+		{"seed", required_argument, NULL, 's'},
+		{0, 0, 0, 0}
+	};
+
+	int c;
+	while ((c = getopt_long(argc, argv, "hb:e:s:", long_options, NULL)) != -1) {
+		switch (c) {
+		case 'b':
+			nbindings = atoi(optarg);
+			break;
+		case 'e':
+			nevents = atoi(optarg);
+			break;
+		case 's':
+			rng_state = strtoull(optarg, NULL, 0) | 1;
+			break;
+		case 'h':
+		default:
+			fprintf(c == 'h' ? stdout : stderr, "%s", usage);
+			return c == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+	if (nbindings < 1 || nevents < BATCH) {
+		fprintf(stderr, "%s", usage);
+		return EXIT_FAILURE;
+	}
+
+	sway_log_init(SWAY_ERROR, NULL);
+
+	list_t *bindings = create_list();
+	for (int i = 0; i < nbindings; ++i) {
+		list_add(bindings, random_binding(i));
+	}
+	struct key_event *events = calloc(nevents, sizeof(struct key_event));
+	for (int i = 0; i < nevents; ++i) {
+		random_event(&events[i], bindings);
+	}
+
+	struct sway_binding_index index = {0};
+	int64_t start = now_ns();
+	binding_index_bucket(&index, bindings, 0, false, 0);
+	int64_t build = now_ns() - start;
+	if (!index.valid) {
+		sway_log(SWAY_ERROR, "Unable to build the binding index");
+		return EXIT_FAILURE;
+	}
+
+	// Check the index against the linear scan over the whole trace
+	int hits = 0;
+	for (int i = 0; i < nevents; ++i) {
+		struct key_event *event = &events[i];
+		struct sway_binding *expected = NULL, *found = NULL;
+		linear_get_active(&event->state, bindings, &expected,
+			event->modifiers, event->release, event->locked, false,
+			bench_input, false, event->group);
+		binding_index_get_active(&event->state, bindings, &index, &found,
+			event->modifiers, event->release, event->locked, false,
+			bench_input, false, event->group);
+		if (expected != found) {
+			sway_log(SWAY_ERROR, "Event %d: index picked binding %d, "
+				"linear scan picked %d", i, found ? found->order : -1,
+				expected ? expected->order : -1);
+			return EXIT_FAILURE;
+		}
+		hits += expected != NULL;
+	}
+
+	// Time both lookups in batches, which keeps the clock out of the result
+	size_t nbatches = nevents / BATCH;
+	double *linear = calloc(nbatches, sizeof(double));
+	double *indexed = calloc(nbatches, sizeof(double));
+	for (size_t b = 0; b < nbatches; ++b) {
+		struct key_event *batch = &events[b * BATCH];
+
+		start = now_ns();
+		for (int i = 0; i < BATCH; ++i) {
+			struct sway_binding *binding = NULL;
+			linear_get_active(&batch[i].state, bindings, &binding,
+				batch[i].modifiers, batch[i].release, batch[i].locked,
+				false, bench_input, false, batch[i].group);
+			bench_sink = binding;
+		}
+		linear[b] = (double)(now_ns() - start) / BATCH;
+
+		start = now_ns();
+		for (int i = 0; i < BATCH; ++i) {
+			struct sway_binding *binding = NULL;
+			binding_index_get_active(&batch[i].state, bindings, &index,
+				&binding, batch[i].modifiers, batch[i].release,
+				batch[i].locked, false, bench_input, false, batch[i].group);
+			bench_sink = binding;
+		}
+		indexed[b] = (double)(now_ns() - start) / BATCH;
+	}
+
+	printf("%d bindings, %d events (%d matched), index built in %.1f us\n",
+		nbindings, nevents, hits, build / 1000.0);
+	printf("per lookup, over batches of %d events:\n", BATCH);
+	report("linear", linear, nbatches);
+	report("indexed", indexed, nbatches);
+
+	free(linear);
+	free(indexed);
+	free(events);
+	binding_index_finish(&index);
+	for (int i = 0; i < bindings->length; ++i) {
+		struct sway_binding *binding = bindings->items[i];
+		list_free_items_and_destroy(binding->keys);
+		free(binding);
+	}
+	list_free(bindings);
+	return EXIT_SUCCESS;
+}
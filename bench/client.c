@@ -0,0 +1,298 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#include <wayland-client.h>
+#include "xdg-shell-client-protocol.h"
+#include "log.h"
+
+// A synthetic xdg-shell client for scroll-bench. It maps a number of
+// toplevels and answers every configure with a solid shm buffer of the
+// configured size, so the compositor sees real commits during the replay.
+
+#define DEFAULT_WIDTH 640
+#define DEFAULT_HEIGHT 480
+
+struct bench_client {
+	struct wl_display *display;
+	struct wl_compositor *compositor;
+	struct wl_shm *shm;
+	struct xdg_wm_base *wm_base;
+	int open;
+};
+
+struct bench_window {
+	struct bench_client *client;
+	struct wl_surface *surface;
+	struct xdg_surface *xdg_surface;
+	struct xdg_toplevel *toplevel;
+	int32_t width, height;
+	uint32_t color;
+	bool closed;
+};
+
+static int anonymous_shm_open(void) {
+	int retries = 100;
+
+	do {
+		// try a probably-unique name
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		pid_t pid = getpid();
+		char name[50];
+		snprintf(name, sizeof(name), "/scroll-bench-%x-%x",
+			(unsigned int)pid, (unsigned int)ts.tv_nsec);
+
+		// shm_open guarantees that O_CLOEXEC is set
+		int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+		if (fd >= 0) {
+			shm_unlink(name);
+			return fd;
+		}
+
+		--retries;
+	} while (retries > 0 && errno == EEXIST);
+
+	return -1;
+}
+
+static void buffer_handle_release(void *data, struct wl_buffer *buffer) {
+	wl_buffer_destroy(buffer);
+}
+
+static const struct wl_buffer_listener buffer_listener = {
+	.release = buffer_handle_release,
+};
+
+static struct wl_buffer *create_buffer(struct bench_client *client,
+		int32_t width, int32_t height, uint32_t color) {
+	int32_t stride = width * 4;
+	size_t size = (size_t)stride * height;
+
+	int fd = anonymous_shm_open();
+	if (fd < 0) {
+		sway_log_errno(SWAY_ERROR, "shm_open failed");
+		return NULL;
+	}
+	if (ftruncate(fd, size) < 0) {
+		sway_log_errno(SWAY_ERROR, "ftruncate failed");
+		close(fd);
+		return NULL;
+	}
+	uint32_t *pixels = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (pixels == MAP_FAILED) {
+		sway_log_errno(SWAY_ERROR, "mmap failed");
+		close(fd);
+		return NULL;
+	}
+	for (size_t i = 0; i < size / 4; ++i) {
+		pixels[i] = color;
+	}
+	munmap(pixels, size);
+
+	struct wl_shm_pool *pool = wl_shm_create_pool(client->shm, fd, size);
+	struct wl_buffer *buffer = wl_shm_pool_create_buffer(pool, 0,
+		width, height, stride, WL_SHM_FORMAT_XRGB8888);
+	wl_shm_pool_destroy(pool);
+	close(fd);
+
+	wl_buffer_add_listener(buffer, &buffer_listener, NULL);
+	return buffer;
+}
+
+static void xdg_surface_handle_configure(void *data,
+		struct xdg_surface *xdg_surface, uint32_t serial) {
+	struct bench_window *window = data;
+	xdg_surface_ack_configure(xdg_surface, serial);
+
+	struct wl_buffer *buffer = create_buffer(window->client,
+		window->width, window->height, window->color);
+	if (!buffer) {
+		return;
+	}
+	wl_surface_attach(window->surface, buffer, 0, 0);
+	wl_surface_damage_buffer(window->surface, 0, 0, INT32_MAX, INT32_MAX);
+	wl_surface_commit(window->surface);
+}
+
+static const struct xdg_surface_listener xdg_surface_listener = {
+	.configure = xdg_surface_handle_configure,
+};
+
+static void xdg_toplevel_handle_configure(void *data,
+		struct xdg_toplevel *toplevel, int32_t width, int32_t height,
+		struct wl_array *states) {
+	struct bench_window *window = data;
+	window->width = width > 0 ? width : DEFAULT_WIDTH;
+	window->height = height > 0 ? height : DEFAULT_HEIGHT;
+}
+
+static void xdg_toplevel_handle_close(void *data,
+		struct xdg_toplevel *toplevel) {
+	struct bench_window *window = data;
+	if (!window->closed) {
+		window->closed = true;
+		window->client->open--;
+	}
+}
+
+static void xdg_toplevel_handle_configure_bounds(void *data,
+		struct xdg_toplevel *toplevel, int32_t width, int32_t height) {
+	// Not needed
+}
+
+static void xdg_toplevel_handle_wm_capabilities(void *data,
+		struct xdg_toplevel *toplevel, struct wl_array *capabilities) {
+	// Not needed
+}
+
+static const struct xdg_toplevel_listener xdg_toplevel_listener = {
+	.configure = xdg_toplevel_handle_configure,
+	.close = xdg_toplevel_handle_close,
+	.configure_bounds = xdg_toplevel_handle_configure_bounds,
+	.wm_capabilities = xdg_toplevel_handle_wm_capabilities,
+};
+
+static void xdg_wm_base_handle_ping(void *data,
+		struct xdg_wm_base *wm_base, uint32_t serial) {
+	xdg_wm_base_pong(wm_base, serial);
+}
+
+static const struct xdg_wm_base_listener xdg_wm_base_listener = {
+	.ping = xdg_wm_base_handle_ping,
+};
+
+static void handle_global(void *data, struct wl_registry *registry,
+		uint32_t name, const char *interface, uint32_t version) {
+	struct bench_client *client = data;
+	if (strcmp(interface, wl_compositor_interface.name) == 0) {
+		client->compositor =
+			wl_registry_bind(registry, name, &wl_compositor_interface, 4);
+	} else if (strcmp(interface, wl_shm_interface.name) == 0) {
+		client->shm = wl_registry_bind(registry, name, &wl_shm_interface, 1);
+	} else if (strcmp(interface, xdg_wm_base_interface.name) == 0) {
+		client->wm_base =
+			wl_registry_bind(registry, name, &xdg_wm_base_interface, 1);
+		xdg_wm_base_add_listener(client->wm_base, &xdg_wm_base_listener, NULL);
+	}
+}
+
+static void handle_global_remove(void *data, struct wl_registry *registry,
+		uint32_t name) {
+	// Who cares
+}
+
+static const struct wl_registry_listener registry_listener = {
+	.global = handle_global,
+	.global_remove = handle_global_remove,
+};
+
+static const char usage[] =
+	"Usage: scroll-bench-client [options...]\n"
+	"\n"
+	"  -h, --help             Show help message and quit.\n"
+	"  -a, --app-id <id>      Set the app_id of the windows.\n"
+	"  -n, --windows <count>  Number of windows to map.\n";
+
+int main(int argc, char **argv) {
+	const char *app_id = "scroll-bench";
+	int count = 1;
+
+	static const struct option long_options[] = {
+		{"help", no_argument, NULL, 'h'},
+		{"app-id", required_argument, NULL, 'a'},
+		{"windows", required_argument, NULL, 'n'},
+		{0, 0, 0, 0}
+	};
+
+	int c;
+	while ((c = getopt_long(argc, argv, "ha:n:", long_options, NULL)) != -1) {
+		switch (c) {
+		case 'a':
+			app_id = optarg;
+			break;
+		case 'n':
+			count = atoi(optarg);
+			break;
+		case 'h':
+		default:
+			fprintf(c == 'h' ? stdout : stderr, "%s", usage);
+			return c == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+	if (count < 1) {
+		fprintf(stderr, "%s", usage);
+		return EXIT_FAILURE;
+	}
+
+	sway_log_init(SWAY_ERROR, NULL);
+
+	struct bench_client client = {0};
+	client.display = wl_display_connect(NULL);
+	if (!client.display) {
+		sway_log(SWAY_ERROR, "Unable to connect to the compositor");
+		return EXIT_FAILURE;
+	}
+
+	struct wl_registry *registry = wl_display_get_registry(client.display);
+	wl_registry_add_listener(registry, &registry_listener, &client);
+	wl_display_roundtrip(client.display);
+	if (!client.compositor || !client.shm || !client.wm_base) {
+		sway_log(SWAY_ERROR, "Compositor is missing wl_compositor, "
+			"wl_shm or xdg_wm_base");
+		return EXIT_FAILURE;
+	}
+
+	struct bench_window *windows = calloc(count, sizeof(struct bench_window));
+	if (!windows) {
+		sway_log(SWAY_ERROR, "Unable to allocate windows");
+		return EXIT_FAILURE;
+	}
+	for (int i = 0; i < count; ++i) {
+		struct bench_window *window = &windows[i];
+		window->client = &client;
+		window->width = DEFAULT_WIDTH;
+		window->height = DEFAULT_HEIGHT;
+		// Spread the colors so the windows are distinguishable when watched
+		window->color = 0xFF000000 | ((i * 0x3F1D27) & 0x00FFFFFF);
+		window->surface = wl_compositor_create_surface(client.compositor);
+		window->xdg_surface =
+			xdg_wm_base_get_xdg_surface(client.wm_base, window->surface);
+		xdg_surface_add_listener(window->xdg_surface,
+			&xdg_surface_listener, window);
+		window->toplevel = xdg_surface_get_toplevel(window->xdg_surface);
+		xdg_toplevel_add_listener(window->toplevel,
+			&xdg_toplevel_listener, window);
+		xdg_toplevel_set_app_id(window->toplevel, app_id);
+		char title[32];
+		snprintf(title, sizeof(title), "%s %d", app_id, i + 1);
+		xdg_toplevel_set_title(window->toplevel, title);
+		wl_surface_commit(window->surface);
+		client.open++;
+	}
+
+	while (client.open > 0 && wl_display_dispatch(client.display) != -1) {
+		// This space intentionally left blank
+	}
+
+	for (int i = 0; i < count; ++i) {
+		struct bench_window *window = &windows[i];
+		xdg_toplevel_destroy(window->toplevel);
+		xdg_surface_destroy(window->xdg_surface);
+		wl_surface_destroy(window->surface);
+	}
+	free(windows);
+	xdg_wm_base_destroy(client.wm_base);
+	wl_shm_destroy(client.shm);
+	wl_compositor_destroy(client.compositor);
+	wl_registry_destroy(registry);
+	wl_display_disconnect(client.display);
+	return EXIT_SUCCESS;
+}
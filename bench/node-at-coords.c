@@ -0,0 +1,434 @@
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <wayland-server-core.h>
+#include <wlr/util/addon.h>
+#include "sway/scene_descriptor.h"
+#include "sway/tree/scene.h"
+#include "log.h"
+
+// Builds a scene tree shaped like the one of a busy workspace, with the
+// descriptors sway assigns, and replays pointer positions against it the way
+// node_at_coords() does: hit-test the scene, then walk up the ancestors of
+// the hit node until one carries a container. The walk is timed with the
+// descriptor slots of the nodes and with the addon set lookups they replaced.
+// Both must find the same container for every point.
+//
+// The tree is built by hand rather than with sway_scene_tree_create(), which
+// would pull the whole compositor into the benchmark.
+
+#define VIEW_WIDTH 800
+#define VIEW_HEIGHT 600
+#define BORDER 2
+#define BATCH 32
+
+// Stand-ins for what the descriptors point to in sway
+struct bench_container {
+	int id;
+};
+
+struct bench_view {
+	struct bench_container *container;
+};
+
+// A descriptor stored the way scene_descriptor.c did before the slots
+struct bench_addon {
+	void *data;
+	struct wlr_addon addon;
+};
+
+// Written after every walk so the timed loops can't be optimized out
+static struct bench_container *volatile bench_sink;
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15;
+
+static uint32_t rng_next(void) {
+	// xorshift64*
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return (rng_state * 0x2545f4914f6cdd1dull) >> 32;
+}
+
+static void addon_handle_destroy(struct wlr_addon *addon) {
+	struct bench_addon *desc = wl_container_of(addon, desc, addon);
+	wlr_addon_finish(&desc->addon);
+	free(desc);
+}
+
+static const struct wlr_addon_interface addon_interface = {
+	.name = "sway_scene_descriptor",
+	.destroy = addon_handle_destroy,
+};
+
+// Stands for the other addons nodes carry, like the one of scene surfaces
+static const struct wlr_addon_interface surface_addon_interface = {
+	.name = "sway_scene_surface",
+	.destroy = addon_handle_destroy,
+};
+
+static void addon_assign(struct sway_scene_node *node,
+		const struct wlr_addon_interface *impl, const void *owner, void *data) {
+	struct bench_addon *desc = calloc(1, sizeof(*desc));
+	desc->data = data;
+	wlr_addon_init(&desc->addon, &node->addons, owner, impl);
+}
+
+static void *addon_try_get(struct sway_scene_node *node,
+		enum sway_scene_descriptor_type type) {
+	struct wlr_addon *addon =
+		wlr_addon_find(&node->addons, (void *)type, &addon_interface);
+	if (!addon) {
+		return NULL;
+	}
+	struct bench_addon *desc = wl_container_of(addon, desc, addon);
+	return desc->data;
+}
+
+// Assigns a descriptor both ways, so the two walks see the same tree
+static void descriptor_assign(struct sway_scene_node *node,
+		enum sway_scene_descriptor_type type, void *data) {
+	scene_descriptor_assign(node, type, data);
+	addon_assign(node, &addon_interface, (void *)type, data);
+}
+
+static void node_init(struct sway_scene_node *node,
+		enum sway_scene_node_type type, struct sway_scene_tree *parent,
+		int x, int y) {
+	*node = (struct sway_scene_node){
+		.type = type,
+		.parent = parent,
+		.enabled = true,
+		.x = x,
+		.y = y,
+		.scale = -1.0f,
+	};
+	wl_list_init(&node->link);
+	wlr_addon_set_init(&node->addons);
+	if (parent) {
+		wl_list_insert(parent->children.prev, &node->link);
+	}
+}
+
+static struct sway_scene_tree *tree_create(struct sway_scene_tree *parent,
+		int x, int y) {
+	struct sway_scene_tree *tree = calloc(1, sizeof(*tree));
+	node_init(&tree->node, SWAY_SCENE_NODE_TREE, parent, x, y);
+	wl_list_init(&tree->children);
+	return tree;
+}
+
+static struct sway_scene_rect *rect_create(struct sway_scene_tree *parent,
+		int x, int y, int width, int height) {
+	struct sway_scene_rect *rect = calloc(1, sizeof(*rect));
+	node_init(&rect->node, SWAY_SCENE_NODE_RECT, parent, x, y);
+	rect->width = width;
+	rect->height = height;
+	return rect;
+}
+
+static void node_destroy(struct sway_scene_node *node) {
+	if (node->type == SWAY_SCENE_NODE_TREE) {
+		struct sway_scene_tree *tree = wl_container_of(node, tree, node);
+		struct sway_scene_node *child, *tmp;
+		wl_list_for_each_safe(child, tmp, &tree->children, link) {
+			node_destroy(child);
+		}
+	}
+	wlr_addon_set_finish(&node->addons);
+	wl_list_remove(&node->link);
+	free(node);
+}
+
+/**
+ * A container as arranged by sway: a tree with the container descriptor
+ * holding the borders and a view tree, whose surface sits under a chain of
+ * subsurface trees. Every view also has a popup on top of its surface.
+ */
+static void container_create(struct sway_scene_tree *workspace,
+		struct bench_container *con, struct bench_view *view, int x, int depth) {
+	struct sway_scene_tree *tree = tree_create(workspace, x, 0);
+	descriptor_assign(&tree->node, SWAY_SCENE_DESC_CONTAINER, con);
+
+	struct sway_scene_tree *border = tree_create(tree, 0, 0);
+	rect_create(border, 0, 0, VIEW_WIDTH, BORDER);
+	rect_create(border, 0, VIEW_HEIGHT - BORDER, VIEW_WIDTH, BORDER);
+	rect_create(border, 0, 0, BORDER, VIEW_HEIGHT);
+	rect_create(border, VIEW_WIDTH - BORDER, 0, BORDER, VIEW_HEIGHT);
+
+	struct sway_scene_tree *content = tree_create(tree, BORDER, BORDER);
+	descriptor_assign(&content->node, SWAY_SCENE_DESC_VIEW, view);
+	struct sway_scene_tree *parent = content;
+	for (int i = 0; i < depth; ++i) {
+		parent = tree_create(parent, 0, 0);
+	}
+	int width = VIEW_WIDTH - 2 * BORDER, height = VIEW_HEIGHT - 2 * BORDER;
+	struct sway_scene_rect *surface = rect_create(parent, 0, 0, width, height);
+	descriptor_assign(&surface->node, SWAY_SCENE_DESC_BUFFER_TIMER, view);
+	addon_assign(&surface->node, &surface_addon_interface, surface, NULL);
+
+	struct sway_scene_tree *popup = tree_create(content, width / 4, height / 4);
+	descriptor_assign(&popup->node, SWAY_SCENE_DESC_POPUP, view);
+	rect_create(popup, 0, 0, width / 4, height / 4);
+}
+
+/**
+ * The part of sway_scene_node_at() the benchmark needs: the topmost enabled
+ * rect under the point, in layout coordinates relative to node.
+ */
+static struct sway_scene_node *node_at(struct sway_scene_node *node,
+		double lx, double ly) {
+	if (!node->enabled) {
+		return NULL;
+	}
+	lx -= node->x;
+	ly -= node->y;
+	if (node->type == SWAY_SCENE_NODE_RECT) {
+		struct sway_scene_rect *rect = wl_container_of(node, rect, node);
+		if (lx >= 0 && lx < rect->width && ly >= 0 && ly < rect->height) {
+			return node;
+		}
+		return NULL;
+	}
+	struct sway_scene_tree *tree = wl_container_of(node, tree, node);
+	struct sway_scene_node *child;
+	wl_list_for_each_reverse(child, &tree->children, link) {
+		struct sway_scene_node *found = node_at(child, lx, ly);
+		if (found) {
+			return found;
+		}
+	}
+	return NULL;
+}
+
+static struct sway_scene_node *scene_at(struct sway_scene_tree *layers,
+		double lx, double ly) {
+	struct sway_scene_node *layer;
+	wl_list_for_each_reverse(layer, &layers->children, link) {
+		if (scene_descriptor_try_get(layer, SWAY_SCENE_DESC_NON_INTERACTIVE)) {
+			continue;
+		}
+		struct sway_scene_node *found = node_at(layer, lx, ly);
+		if (found) {
+			return found;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * The ancestor walk of node_at_coords(), with the lookup the compositor uses.
+ */
+static struct bench_container *walk_slots(struct sway_scene_node *node) {
+	while (node) {
+		struct bench_container *con =
+			scene_descriptor_try_get(node, SWAY_SCENE_DESC_CONTAINER);
+		if (!con) {
+			struct bench_view *view =
+				scene_descriptor_try_get(node, SWAY_SCENE_DESC_VIEW);
+			if (view) {
+				con = view->container;
+			}
+		}
+		if (!con) {
+			struct bench_view *view =
+				scene_descriptor_try_get(node, SWAY_SCENE_DESC_POPUP);
+			if (view) {
+				con = view->container;
+			}
+		}
+		if (con) {
+			return con;
+		}
+		if (scene_descriptor_try_get(node, SWAY_SCENE_DESC_LAYER_SHELL) ||
+				scene_descriptor_try_get(node,
+					SWAY_SCENE_DESC_XWAYLAND_UNMANAGED)) {
+			return NULL;
+		}
+		node = node->parent ? &node->parent->node : NULL;
+	}
+	return NULL;
+}
+
+/**
+ * The same walk over addon sets, as it ran before the descriptor slots.
+ */
+static struct bench_container *walk_addons(struct sway_scene_node *node) {
+	while (node) {
+		struct bench_container *con =
+			addon_try_get(node, SWAY_SCENE_DESC_CONTAINER);
+		if (!con) {
+			struct bench_view *view = addon_try_get(node, SWAY_SCENE_DESC_VIEW);
+			if (view) {
+				con = view->container;
+			}
+		}
+		if (!con) {
+			struct bench_view *view = addon_try_get(node, SWAY_SCENE_DESC_POPUP);
+			if (view) {
+				con = view->container;
+			}
+		}
+		if (con) {
+			return con;
+		}
+		if (addon_try_get(node, SWAY_SCENE_DESC_LAYER_SHELL) ||
+				addon_try_get(node, SWAY_SCENE_DESC_XWAYLAND_UNMANAGED)) {
+			return NULL;
+		}
+		node = node->parent ? &node->parent->node : NULL;
+	}
+	return NULL;
+}
+
+static int64_t now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int double_cmp(const void *a, const void *b) {
+	double da = *(const double *)a, db = *(const double *)b;
+	return da < db ? -1 : da > db;
+}
+
+static void report(const char *name, double *samples, size_t len) {
+	double total = 0;
+	for (size_t i = 0; i < len; ++i) {
+		total += samples[i];
+	}
+	qsort(samples, len, sizeof(double), double_cmp);
+	printf("%-8s p50 %8.1f ns  p99 %8.1f ns  mean %8.1f ns\n", name,
+		samples[len / 2], samples[len * 99 / 100], total / len);
+}
+
+static const char usage[] =
+	"Usage: node-at-coords [options...]\n"
+	"\n"
+	"  -h, --help              Show help message and quit.\n"
+	"  -v, --views <count>     Number of views on the workspace (default 64).\n"
+	"  -d, --depth <count>     Subsurface trees above each surface (default 8).\n"
+	"  -p, --points <count>    Number of pointer positions (default 200000).\n"
+	"  -s, --seed <seed>       Seed of the pointer positions.\n";
+
+int main(int argc, char **argv) {
+	int nviews = 64;
+	int depth = 8;
+	int npoints = 200000;
+
+	static const struct option long_options[] = {
+		{"help", no_argument, NULL, 'h'},
+		{"views", required_argument, NULL, 'v'},
+		{"depth", required_argument, NULL, 'd'},
+		{"points", required_argument, NULL, 'p'},
+		{"seed", required_argument, NULL, 's'},
+		{0, 0, 0, 0}
+	};
+
+	int c;
+	while ((c = getopt_long(argc, argv, "hv:d:p:s:", long_options, NULL)) != -1) {
+		switch (c) {
+		case 'v':
+			nviews = atoi(optarg);
+			break;
+		case 'd':
+			depth = atoi(optarg);
+			break;
+		case 'p':
+			npoints = atoi(optarg);
+			break;
+		case 's':
+			rng_state = strtoull(optarg, NULL, 0) | 1;
+			break;
+		case 'h':
+		default:
+			fprintf(c == 'h' ? stdout : stderr, "%s", usage);
+			return c == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+	if (nviews < 1 || depth < 0 || npoints < BATCH) {
+		fprintf(stderr, "%s", usage);
+		return EXIT_FAILURE;
+	}
+
+	sway_log_init(SWAY_ERROR, NULL);
+
+	// Layers as in the root of sway: the first one is never hit-tested, and
+	// the last one is empty so every lookup walks past it
+	struct sway_scene_tree *root = tree_create(NULL, 0, 0);
+	struct sway_scene_tree *background = tree_create(root, 0, 0);
+	descriptor_assign(&background->node, SWAY_SCENE_DESC_NON_INTERACTIVE, root);
+	rect_create(background, 0, 0, nviews * VIEW_WIDTH, VIEW_HEIGHT);
+	struct sway_scene_tree *tiling = tree_create(root, 0, 0);
+	tree_create(root, 0, 0);
+	struct sway_scene_tree *workspace = tree_create(tiling, 0, 0);
+
+	struct bench_container *cons = calloc(nviews, sizeof(*cons));
+	struct bench_view *views = calloc(nviews, sizeof(*views));
+	for (int i = 0; i < nviews; ++i) {
+		cons[i].id = i;
+		views[i].container = &cons[i];
+		container_create(workspace, &cons[i], &views[i], i * VIEW_WIDTH, depth);
+	}
+
+	// Hit-test every point once, then check both walks agree on all of them
+	struct sway_scene_node **hits = calloc(npoints, sizeof(*hits));
+	int64_t start = now_ns();
+	for (int i = 0; i < npoints; ++i) {
+		double lx = rng_next() % (nviews * VIEW_WIDTH);
+		double ly = rng_next() % VIEW_HEIGHT;
+		hits[i] = scene_at(root, lx, ly);
+	}
+	double hit_test = (double)(now_ns() - start) / npoints;
+
+	int found = 0;
+	for (int i = 0; i < npoints; ++i) {
+		struct bench_container *expected = walk_addons(hits[i]);
+		struct bench_container *con = walk_slots(hits[i]);
+		if (expected != con) {
+			sway_log(SWAY_ERROR, "Point %d: slots found container %d, "
+				"addons found %d", i, con ? con->id : -1,
+				expected ? expected->id : -1);
+			return EXIT_FAILURE;
+		}
+		found += con != NULL;
+	}
+
+	// Time both walks in batches, which keeps the clock out of the result
+	size_t nbatches = npoints / BATCH;
+	double *addons = calloc(nbatches, sizeof(double));
+	double *slots = calloc(nbatches, sizeof(double));
+	for (size_t b = 0; b < nbatches; ++b) {
+		struct sway_scene_node **batch = &hits[b * BATCH];
+
+		start = now_ns();
+		for (int i = 0; i < BATCH; ++i) {
+			bench_sink = walk_addons(batch[i]);
+		}
+		addons[b] = (double)(now_ns() - start) / BATCH;
+
+		start = now_ns();
+		for (int i = 0; i < BATCH; ++i) {
+			bench_sink = walk_slots(batch[i]);
+		}
+		slots[b] = (double)(now_ns() - start) / BATCH;
+	}
+
+	printf("%d views, %d subsurface levels, %d points (%d on a container)\n",
+		nviews, depth, npoints, found);
+	printf("hit-test %.1f ns per point\n", hit_test);
+	printf("ancestor walk per point, over batches of %d points:\n", BATCH);
+	report("addons", addons, nbatches);
+	report("slots", slots, nbatches);
+
+	free(addons);
+	free(slots);
+	free(hits);
+	node_destroy(&root->node);
+	free(views);
+	free(cons);
+	return EXIT_SUCCESS;
+}
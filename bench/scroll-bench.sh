@@ -0,0 +1,141 @@
+#!/bin/sh
+#
+# Replays a command script against a headless scroll and prints the frame,
+# transaction and animation timing statistics collected with -D perf.
+#
+# Usage: scroll-bench.sh <scroll> <scrollmsg> <client> <config> <commands>
+#
+# Environment:
+#   SCROLL_BENCH_CLIENTS  number of synthetic windows to map (default 8)
+#   SCROLL_BENCH_ROUNDS   times the command script is replayed (default 20)
+#   SCROLL_BENCH_DELAY    pause between commands in seconds (default 0.05)
+#   SCROLL_BENCH_LOG      keep the compositor log at this path
+
+set -eu
+
+if [ $# -ne 5 ]; then
+	echo "Usage: $0 <scroll> <scrollmsg> <client> <config> <commands>" >&2
+	exit 1
+fi
+
+scroll=$1
+scrollmsg=$2
+client=$3
+config=$4
+commands=$5
+
+clients=${SCROLL_BENCH_CLIENTS:-8}
+rounds=${SCROLL_BENCH_ROUNDS:-20}
+delay=${SCROLL_BENCH_DELAY:-0.05}
+
+runtime=$(mktemp -d "${TMPDIR:-/tmp}/scroll-bench.XXXXXX")
+log=${SCROLL_BENCH_LOG:-$runtime/scroll.log}
+scroll_pid=
+client_pid=
+
+cleanup() {
+	if [ -n "$client_pid" ]; then
+		kill "$client_pid" 2>/dev/null || true
+	fi
+	if [ -n "$scroll_pid" ]; then
+		kill "$scroll_pid" 2>/dev/null || true
+		wait "$scroll_pid" 2>/dev/null || true
+	fi
+	rm -rf "$runtime"
+}
+trap cleanup EXIT INT TERM
+
+# Wait up to ~10s for a condition to hold
+wait_for() {
+	i=0
+	while ! eval "$1"; do
+		i=$((i + 1))
+		if [ $i -gt 200 ]; then
+			echo "scroll-bench: timed out waiting for $2" >&2
+			if [ -f "$log" ]; then
+				tail -n 20 "$log" >&2
+			fi
+			exit 1
+		fi
+		sleep 0.05
+	done
+}
+
+unset WAYLAND_DISPLAY DISPLAY SWAYSOCK
+export XDG_RUNTIME_DIR="$runtime"
+export WLR_BACKENDS=headless
+export WLR_RENDERER=pixman
+export WLR_HEADLESS_OUTPUTS=1
+export WLR_LIBINPUT_NO_DEVICES=1
+
+"$scroll" -D perf -c "$config" >"$log" 2>&1 &
+scroll_pid=$!
+
+export SWAYSOCK="$runtime/sway-ipc.$(id -u).$scroll_pid.sock"
+wait_for '[ -S "$SWAYSOCK" ] && "$scrollmsg" -q -t get_version' "the IPC socket"
+
+display=
+find_display() {
+	for socket in "$runtime"/wayland-*; do
+		case "$socket" in
+		*.lock) ;;
+		*) if [ -S "$socket" ]; then display=${socket##*/}; return 0; fi ;;
+		esac
+	done
+	return 1
+}
+wait_for find_display "the wayland socket"
+export WAYLAND_DISPLAY="$display"
+
+"$client" -n "$clients" -a scroll-bench &
+client_pid=$!
+
+mapped() {
+	n=$("$scrollmsg" -r -t get_tree | grep -o '"app_id": *"scroll-bench"' | wc -l)
+	[ "$n" -ge "$clients" ]
+}
+wait_for mapped "$clients windows to map"
+
+# jump waits for a key to pick a window. Without a keyboard it can only be
+# dismissed through a virtual keyboard, so it is skipped when wtype is missing.
+have_wtype=
+if command -v wtype >/dev/null 2>&1; then
+	have_wtype=1
+else
+	echo "scroll-bench: wtype not found, skipping jump" >&2
+fi
+
+round=0
+while [ $round -lt "$rounds" ]; do
+	while IFS= read -r line; do
+		case "$line" in
+		''|'#'*) continue ;;
+		jump*)
+			if [ -z "$have_wtype" ]; then
+				continue
+			fi
+			"$scrollmsg" -q -- "$line"
+			sleep "$delay"
+			wtype -k Escape
+			;;
+		*)
+			"$scrollmsg" -q -- "$line" || echo "scroll-bench: '$line' failed" >&2
+			;;
+		esac
+		sleep "$delay"
+	done <"$commands"
+	round=$((round + 1))
+done
+
+"$scrollmsg" -p -t get_perf
+
+kill "$client_pid" 2>/dev/null || true
+wait "$client_pid" 2>/dev/null || true
+client_pid=
+
+"$scrollmsg" -q exit || true
+wait "$scroll_pid" || true
+scroll_pid=
+
+echo
+grep 'perf:' "$log" | sed 's/^.*perf:/perf:/'
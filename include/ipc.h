@@ -1,7 +1,7 @@
 #ifndef _SWAY_IPC_H
 #define _SWAY_IPC_H
 
-#define event_mask(ev) (1 << (ev & 0x7F))
+#define event_mask(ev) (1ULL << (ev & 0x7F))
 
 enum ipc_command_type {
 	// i3 command types - see i3's I3_REPLY_TYPE constants
@@ -26,6 +26,7 @@ enum ipc_command_type {
 	// scroll-specific command types
 	IPC_GET_SCROLLER = 120,
 	IPC_GET_TRAILS = 121,
+	IPC_GET_PERF = 122,
 
 	// Events sent from sway to clients. Events have the highest bits set.
 	IPC_EVENT_WORKSPACE = ((1<<31) | 0),
@@ -44,6 +45,9 @@ enum ipc_command_type {
 	// scroll-specific event types
 	IPC_EVENT_SCROLLER = ((1<<31) | 30),
 	IPC_EVENT_TRAILS = ((1<<31) | 31),
+	IPC_EVENT_TREE = ((1<<31) | 32),
+	IPC_EVENT_PERF = ((1<<31) | 33),
+	IPC_EVENT_STATE = ((1<<31) | 34),
 };
 
 #endif
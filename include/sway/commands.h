@@ -6,6 +6,7 @@
 #include "stringop.h"
 
 struct sway_container;
+struct cmd_program;
 
 typedef struct cmd_results *sway_cmd(int argc, char **argv);
 
@@ -59,6 +60,25 @@ const struct cmd_handler *find_handler(const char *line,
  */
 list_t *execute_command(char *command,  struct sway_seat *seat,
 		struct sway_container *con);
+/**
+ * Splits a command list into commands and looks up their handlers once, so
+ * that it can be run many times without being parsed again. Variables and
+ * criteria referring to the focus are still resolved on every run.
+ */
+struct cmd_program *cmd_program_compile(const char *command);
+list_t *cmd_program_run(struct cmd_program *program, struct sway_seat *seat,
+		struct sway_container *con);
+/**
+ * Releases a compiled program. It is freed once no run is using it anymore.
+ */
+void cmd_program_destroy(struct cmd_program *program);
+/**
+ * Like execute_command, but compiles the command into *program the first time
+ * it runs and reuses it afterwards. Used for commands that run repeatedly,
+ * like those of bindings.
+ */
+list_t *execute_command_program(struct cmd_program **program, char *command,
+		struct sway_seat *seat, struct sway_container *con);
 /**
  * Parse and handles a command during config file loading.
  *
@@ -145,11 +165,13 @@ sway_cmd cmd_fullscreen_movefocus;
 sway_cmd cmd_gaps;
 sway_cmd cmd_gesture_scroll_enable;
 sway_cmd cmd_gesture_scroll_fingers;
+sway_cmd cmd_gesture_scroll_friction;
 sway_cmd cmd_gesture_scroll_sensitivity;
 sway_cmd cmd_hide_edge_borders;
 sway_cmd cmd_include;
 sway_cmd cmd_inhibit_idle;
 sway_cmd cmd_input;
+sway_cmd cmd_ipc_backlog_limit;
 sway_cmd cmd_seat;
 sway_cmd cmd_ipc;
 sway_cmd cmd_jump;
@@ -161,6 +183,7 @@ sway_cmd cmd_kill;
 sway_cmd cmd_layout_default_height;
 sway_cmd cmd_layout_default_width;
 sway_cmd cmd_layout_heights;
+sway_cmd cmd_layout_offscreen_margin;
 sway_cmd cmd_layout_transpose;
 sway_cmd cmd_layout_widths;
 sway_cmd cmd_log_colors;
@@ -345,6 +368,7 @@ sway_cmd cmd_ipc_event_cmd;
 
 sway_cmd animations_cmd_enabled;
 sway_cmd animations_cmd_default;
+sway_cmd animations_cmd_frame_clock;
 sway_cmd animations_cmd_frequency;
 sway_cmd animations_cmd_window_open;
 sway_cmd animations_cmd_window_move;
@@ -67,6 +67,7 @@ struct sway_binding {
 	uint32_t modifiers;
 	xkb_layout_index_t group;
 	char *command;
+	struct cmd_program *program; // command compiled on its first run
 };
 
 enum sway_switch_trigger {
@@ -83,6 +84,7 @@ struct sway_switch_binding {
 	enum sway_switch_trigger trigger;
 	uint32_t flags;
 	char *command;
+	struct cmd_program *program; // command compiled on its first run
 };
 
 /**
@@ -93,6 +95,7 @@ struct sway_gesture_binding {
 	uint32_t flags;
 	struct gesture gesture;
 	char *command;
+	struct cmd_program *program; // command compiled on its first run
 };
 
 /**
@@ -105,6 +108,20 @@ enum sway_fowa {
 	FOWA_NONE,
 };
 
+#define SWAY_BINDING_INDEX_BUCKETS 256
+
+/**
+ * Lookup table over a mode's key binding list, bucketed by modifiers, release
+ * flag and first key. The bindings of bucket i are at the list positions
+ * positions[offsets[i]] to positions[offsets[i + 1] - 1], in list order.
+ * Rebuilt lazily on the first lookup after the bindings changed.
+ */
+struct sway_binding_index {
+	bool valid;
+	int offsets[SWAY_BINDING_INDEX_BUCKETS + 1];
+	int *positions;
+};
+
 /**
  * A "mode" of keybindings created via the `mode` command.
  */
@@ -112,6 +129,8 @@ struct sway_mode {
 	char *name;
 	list_t *keysym_bindings;
 	list_t *keycode_bindings;
+	struct sway_binding_index keysym_index;
+	struct sway_binding_index keycode_index;
 	list_t *mouse_bindings;
 	list_t *switch_bindings;
 	list_t *gesture_bindings;
@@ -123,6 +142,7 @@ struct sway_mode {
  */
 struct sway_animations_config {
 	bool enabled;
+	bool frame_clock;
 	uint32_t frequency_ms;
 	struct sway_animation_curve *anim_default;
 	struct sway_animation_curve *window_open;
@@ -569,6 +589,8 @@ struct sway_config {
 	bool tiling_drag;
 	int tiling_drag_threshold;
 
+	size_t ipc_backlog_limit; // bytes an IPC client may leave unread
+
 	enum smart_gaps_mode smart_gaps;
 	int gaps_inner;
 	struct side_gaps gaps_outer;
@@ -610,6 +632,7 @@ struct sway_config {
 	double layout_default_height;
 	list_t *layout_widths;
 	list_t *layout_heights;
+	int layout_offscreen_margin; // -1 arranges every container
 	float jump_labels_color[4];
 	float jump_labels_background[4];
 	double jump_labels_scale;
@@ -618,6 +641,7 @@ struct sway_config {
 	bool gesture_scroll_enable;
 	uint32_t gesture_scroll_fingers;
 	float gesture_scroll_sentitivity;
+	float gesture_scroll_friction;
 
 	struct sway_animations_config animations;
 
@@ -765,6 +789,14 @@ void free_gesture_binding(struct sway_gesture_binding *binding);
 
 void seat_execute_command(struct sway_seat *seat, struct sway_binding *binding);
 
+/**
+ * Like seat_execute_command, caching the compiled command in *program rather
+ * than in the binding. Switch and gesture bindings run through short-lived
+ * dummy bindings and pass the field of the binding they stand for.
+ */
+void seat_execute_binding_command(struct sway_seat *seat,
+		struct sway_binding *binding, struct cmd_program **program);
+
 void load_swaybar(struct bar_config *bar);
 
 void load_swaybars(void);
@@ -796,6 +828,21 @@ void translate_keysyms(struct input_config *input_config);
 
 void binding_add_translated(struct sway_binding *binding, list_t *bindings);
 
+/**
+ * Mark the key binding indexes of the mode as stale.
+ */
+void binding_index_invalidate(struct sway_mode *mode);
+
+void binding_index_finish(struct sway_binding_index *index);
+
+/**
+ * Return the bucket of the index holding the bindings with the given
+ * modifiers, release flag and first key, rebuilding the index from the
+ * binding list if needed. The bucket may also hold unrelated bindings.
+ */
+int binding_index_bucket(struct sway_binding_index *index, list_t *bindings,
+		uint32_t modifiers, bool release, uint32_t key);
+
 /* Global config singleton. */
 extern struct sway_config *config;
 
@@ -27,12 +27,18 @@ enum pattern_type {
 struct pattern {
 	enum pattern_type match_type;
 	pcre2_code *regex;
+	// For regexes of the form ^literal$ or ^literal, the unescaped literal.
+	// Used to find candidate criteria without running the regex.
+	char *literal;
+	size_t literal_len;
+	bool literal_exact; // anchored at both ends
 };
 
 struct criteria {
 	enum criteria_type type;
 	char *raw; // entire criteria string (for logging)
 	char *cmdlist;
+	struct cmd_program *program; // cmdlist compiled on its first run
 	char *target; // workspace or output name for `assign` criteria
 
 	struct pattern *title;
@@ -65,6 +71,14 @@ bool criteria_already_exists(struct criteria *criteria);
 
 void criteria_destroy(struct criteria *criteria);
 
+/**
+ * Invalidate the match caches and dispatch index. Call whenever criteria are
+ * removed from config->criteria or the list is freed.
+ */
+void criteria_invalidate(void);
+
+void criteria_cache_destroy(struct criteria_cache *cache);
+
 /**
  * Generate a criteria struct from a raw criteria string such as
  * [class="foo" instance="bar"] (brackets inclusive).
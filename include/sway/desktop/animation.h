@@ -2,8 +2,11 @@
 #define _SWAY_ANIMATION_H
 #include <stdint.h>
 #include <stdbool.h>
+#include <time.h>
 #include "list.h"
 
+struct sway_output;
+
 /**
  * Animations.
  */
@@ -25,6 +28,20 @@ struct sway_animation {
 	uint32_t nsteps;
 	uint32_t step;
 
+	// Frame clock mode: progress is sampled at each output's predicted
+	// presentation time instead of being advanced by the timer, and each
+	// output keeps its own (sway_output.animation_progress)
+	bool running;
+	struct timespec start;
+	uint32_t duration_ms;
+
+	// Curve parameter in [0, 1] for the step being evaluated
+	double progress;
+	// Output the step is evaluated for, NULL if it applies to all of them
+	struct sway_output *output;
+	// When the last step was evaluated, for the perf statistics
+	struct timespec last_step;
+
 	enum sway_animation_mode mode;
 	sway_animation_callback_func_t callback_step;
 	void *data_step;
@@ -56,6 +73,19 @@ void animation_create(enum sway_animation_mode mode);
 // Is an animation enabled?
 bool animation_enabled();
 
+// Is a frame clock driven animation waiting for output frames?
+bool animation_frame_clock_running();
+
+// Evaluate one step of a frame clock driven animation for output, at the time
+// its frame being rendered is expected to be presented. Called from the output
+// repaint handler, so each refresh of each output gets one step of its own.
+void animation_frame(struct sway_output *output, const struct timespec *when);
+
+// Output whose frame the current step is evaluated for. Step callbacks only
+// need to re-arrange what is shown on it. NULL if the step applies to every
+// output (timer mode, the first and the last frame clock steps).
+struct sway_output *animation_frame_output();
+
 // Get the current parameters for the active animation
 void animation_get_values(double *t, double *x, double *y, double *offset_scale);
 
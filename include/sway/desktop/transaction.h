@@ -36,6 +36,14 @@ void transaction_commit_dirty(void);
  */
 void transaction_commit_dirty_client(void);
 
+/**
+ * Holds back the commits of dirty nodes until the matching
+ * transaction_batch_end(), which commits them as a single transaction. Used to
+ * run a command list without exposing its intermediate states. Batches nest.
+ */
+void transaction_batch_begin(void);
+void transaction_batch_end(void);
+
 /**
  * Notify the transaction system that a view is ready for the new layout.
  *
@@ -48,6 +48,17 @@ struct sway_shortcut_state {
 	uint32_t current_key;
 };
 
+/**
+ * If one exists, finds a binding which matches the shortcut model state,
+ * current modifiers, release state, and locked state. Only the index buckets
+ * of the first pressed key and the newly-pressed key are searched.
+ */
+void binding_index_get_active(const struct sway_shortcut_state *state,
+		list_t *bindings, struct sway_binding_index *index,
+		struct sway_binding **current_binding,
+		uint32_t modifiers, bool release, bool locked, bool inhibited,
+		const char *input, bool exact_input, xkb_layout_index_t group);
+
 typedef void (*sway_keyboard_cb_fn)(struct sway_keyboard *keyboard,
 		struct wlr_keyboard_key_event *event, void *data);
 
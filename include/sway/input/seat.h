@@ -70,6 +70,8 @@ struct sway_seat_node {
 	struct sway_node *node;
 
 	struct wl_list link; // sway_seat::focus_stack
+	// Position in the focus stack, higher is more recently focused
+	int64_t serial;
 
 	struct wl_listener destroy;
 };
@@ -95,6 +97,7 @@ struct sway_seat {
 
 	bool has_focus;
 	struct wl_list focus_stack; // list of containers in focus order
+	int64_t focus_serial_top, focus_serial_bottom; // see sway_seat_node::serial
 	struct sway_workspace *workspace;
 	char *prev_workspace_name; // for workspace back_and_forth
 
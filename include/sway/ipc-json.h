@@ -18,5 +18,7 @@ json_object *ipc_json_describe_seat(struct sway_seat *seat);
 json_object *ipc_json_describe_bar_config(struct bar_config *bar);
 json_object *ipc_json_describe_scroller(struct sway_workspace *workspace);
 json_object *ipc_json_describe_trails();
+json_object *ipc_json_describe_perf(void);
+json_object *ipc_json_describe_tree_change(struct sway_node *node, uint32_t changes);
 
 #endif
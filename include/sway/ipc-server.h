@@ -25,4 +25,19 @@ void ipc_event_output(void);
 void ipc_event_scroller(const char *change, struct sway_workspace *workspace);
 void ipc_event_trails();
 
+enum ipc_tree_change {
+	IPC_TREE_NEW = 1 << 0,
+	IPC_TREE_CLOSE = 1 << 1,
+	IPC_TREE_MOVE = 1 << 2,
+	IPC_TREE_GEOMETRY = 1 << 3,
+	IPC_TREE_FOCUS = 1 << 4,
+	IPC_TREE_CHILDREN = 1 << 5,
+};
+
+// The tree event carries the changes of one transaction. Nodes are added
+// with their current state once it has been applied, then the event is sent.
+bool ipc_event_tree_has_listeners(void);
+void ipc_event_tree_add(struct sway_node *node, uint32_t changes);
+void ipc_event_tree_send(void);
+
 #endif
@@ -10,6 +10,7 @@
 #include "sway/tree/node.h"
 #include "sway/tree/view.h"
 #include "sway/tree/layout.h"
+#include "sway/perf.h"
 
 struct sway_server;
 struct sway_container;
@@ -70,11 +71,14 @@ struct sway_output {
 
 	struct timespec last_presentation;
 	uint32_t refresh_nsec;
+	double animation_progress; // Frame clock animation step shown last
 	int max_render_time; // In milliseconds
 	struct wl_event_source *repaint_timer;
 	bool allow_tearing;
 
 	struct sway_scroller_output_options scroller_options;
+
+	struct sway_output_perf perf;
 };
 
 struct sway_output_non_desktop {
@@ -0,0 +1,116 @@
+#ifndef _SWAY_PERF_H
+#define _SWAY_PERF_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "sway/tree/scene.h"
+#include "list.h"
+
+enum sway_perf_metric {
+	PERF_FRAME_CPU,         // CPU time spent producing an output frame
+	PERF_TXN_LATENCY,       // From transaction commit to apply
+	PERF_ANIMATION_STEP,    // Interval between frame clock animation steps
+	PERF_METRIC_COUNT,
+};
+
+// Each power of two is split in 1 << PERF_HISTOGRAM_SUB_BITS buckets, so a
+// percentile read from the histogram is off by at most 25%
+#define PERF_HISTOGRAM_SUB_BITS 2
+#define PERF_HISTOGRAM_BUCKETS (64 << PERF_HISTOGRAM_SUB_BITS)
+
+// Transaction statistics are kept for this many clients, the rest are
+// accounted together
+#define PERF_CLIENTS_MAX 32
+
+struct sway_perf_histogram {
+	uint64_t count;
+	int64_t min, max;
+	uint64_t buckets[PERF_HISTOGRAM_BUCKETS];
+};
+
+/**
+ * Transaction statistics of a client, by app_id. Counts the transactions in
+ * which it was the last one to be ready, and those which timed out waiting for
+ * it.
+ */
+struct sway_perf_client {
+	char *app_id; // NULL for the clients that didn't fit
+	uint64_t slowest;
+	uint64_t timeouts;
+	int64_t wait_total, wait_max;
+};
+
+/**
+ * Per output frame statistics, part of struct sway_output.
+ */
+struct sway_output_perf {
+	// Render timer of the last frame, read when building the next one
+	struct sway_scene_timer timer;
+	bool timer_pending;
+
+	// Set when a frame is committed, cleared when it is presented
+	bool frame_pending;
+	struct timespec commit_time;
+	struct timespec predicted;
+
+	uint64_t frames;
+	uint64_t missed_vblanks;
+	struct sway_perf_histogram build_state;
+	struct sway_perf_histogram render;
+	struct sway_perf_histogram present_latency;
+};
+
+struct sway_perf {
+	struct sway_perf_histogram histograms[PERF_METRIC_COUNT];
+	uint64_t txn_timeouts;
+	list_t *clients; // struct sway_perf_client
+};
+
+extern struct sway_perf perf;
+
+const char *perf_metric_name(enum sway_perf_metric metric);
+
+/**
+ * Adds a sample in nanoseconds to the histogram.
+ */
+void perf_histogram_add(struct sway_perf_histogram *histogram, int64_t nsec);
+
+/**
+ * Returns the upper bound of the bucket holding the given percentile, or 0 if
+ * there are no samples.
+ */
+int64_t perf_histogram_percentile(const struct sway_perf_histogram *histogram,
+		double percentile);
+
+/**
+ * Returns the upper bound of the values counted in a bucket.
+ */
+int64_t perf_histogram_bucket_bound(int index);
+
+void perf_record(enum sway_perf_metric metric, int64_t nsec);
+
+/**
+ * Records the time elapsed since start, taken from the same clock.
+ */
+void perf_record_since(enum sway_perf_metric metric, clockid_t clock,
+		const struct timespec *start);
+
+/**
+ * Accounts a transaction to the client it waited for the longest.
+ */
+void perf_record_txn_slowest(const char *app_id, int64_t wait_nsec);
+
+/**
+ * Accounts a client that didn't get ready before the transaction timeout.
+ */
+void perf_record_txn_timeout(const char *app_id);
+
+/**
+ * Logs count, p50, p99 and max of every metric, if the perf debug flag is set.
+ */
+void perf_report(void);
+
+void perf_finish(void);
+
+#endif
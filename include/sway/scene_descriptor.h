@@ -19,8 +19,11 @@ enum sway_scene_descriptor_type {
 	SWAY_SCENE_DESC_XWAYLAND_UNMANAGED,
 	SWAY_SCENE_DESC_POPUP,
 	SWAY_SCENE_DESC_DRAG_ICON,
+	SWAY_SCENE_DESC_COUNT,
 };
 
+// Descriptors are stored in a slot of the node, so lookups are a single
+// pointer read. Assigning a type again replaces the previous value.
 bool scene_descriptor_assign(struct sway_scene_node *node,
 	enum sway_scene_descriptor_type type, void *data);
 
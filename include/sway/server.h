@@ -151,6 +151,7 @@ struct sway_debug {
 	bool noatomic;         // Ignore atomic layout updates
 	bool txn_timings;      // Log verbose messages about transactions
 	bool txn_wait;         // Always wait for the timeout before applying
+	bool perf;             // Log the timing histograms on shutdown
 };
 
 extern struct sway_debug debug;
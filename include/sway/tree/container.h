@@ -141,6 +141,10 @@ struct sway_container {
 		double w1, h1;
 	} animation;
 
+	// Left out of the last arrangement for being outside the viewport, see
+	// layout_offscreen_margin
+	bool offscreen;
+
 	bool selected;	// for selection/cut/move
 
 	// Indicates that the container is a scratchpad container.
@@ -1,6 +1,7 @@
 #ifndef _SWAY_LAYOUT_H
 #define _SWAY_LAYOUT_H
 
+#include <time.h>
 #include "sway/tree/container.h"
 #include <wlr/util/edges.h>
 
@@ -81,6 +82,13 @@ struct sway_scroller {
 		float scale;
 		struct sway_scene_tree *tree;
 		struct sway_text_node *text;
+		// Offscreen copy of the workspace at its overview size. It is only
+		// redrawn when the workspace takes damage.
+		struct {
+			struct wlr_buffer *buffer;
+			struct wlr_texture *texture;
+			bool dirty;
+		} thumbnail;
 	} workspaces;
 };
 
@@ -96,6 +104,18 @@ list_t *layout_get_heights(struct sway_output *output);
 void layout_init(struct sway_workspace *workspace);
 void layout_set_type(struct sway_workspace *workspace, enum sway_container_layout type);
 enum sway_container_layout layout_get_type(struct sway_workspace *workspace);
+// Active tiling child of a workspace or container, from the seat focus rather
+// than the current state. current.focused_inactive_child is only updated when
+// a transaction is applied, which in a command chain is after the last command.
+struct sway_container *layout_get_active_child(struct sway_node *parent);
+// Prefix sums of the scaled extents of a row of containers, inner gaps
+// included: sums[i] is the extent of children[0] to children[i - 1], and
+// sums[children->length] the extent of the whole row. Widths are used for
+// L_HORIZ and heights otherwise, from the current state if current is set and
+// the pending one if not. The array is a scratch buffer shared by all callers
+// and is only valid until the next call. Returns NULL if it cannot grow.
+const double *layout_row_extents(enum sway_container_layout layout,
+	list_t *children, int gaps, double scale, bool current);
 
 // Toggle overview will only trigger a workspace arrangement where it will call
 // layout_overview_recompute_scale()
@@ -108,6 +128,8 @@ bool layout_overview_enabled(struct sway_workspace *workspace);
 
 bool layout_overview_workspaces_enabled();
 void layout_overview_workspaces_toggle();
+// Free the workspace's overview thumbnail, it will be recreated on demand
+void layout_overview_workspaces_thumbnail_release(struct sway_workspace *workspace);
 
 void layout_scale_set(struct sway_workspace *workspace, float scale);
 void layout_scale_reset(struct sway_workspace *workspace);
@@ -159,6 +181,10 @@ bool layout_scroll_begin(struct sway_seat *seat);
 void layout_scroll_update(struct sway_seat *seat, double dx, double dy);
 // Finish scrolling swipe and return true if scrolling, else false
 bool layout_scroll_end(struct sway_seat *seat);
+// Apply the scrolling accumulated for the workspaces of the output since its
+// last frame, and advance kinetic scrolling to the time the frame is expected
+// to be presented. Return true if kinetic scrolling needs more frames.
+bool layout_scroll_frame(struct sway_output *output, const struct timespec *when);
 
 // Pin
 
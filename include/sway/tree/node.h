@@ -40,6 +40,8 @@ struct sway_node {
 	struct sway_transaction_instruction *instruction;
 	size_t ntxnrefs;
 	bool destroying;
+	// Set once a transaction has applied the node's state
+	bool applied;
 
 	// If true, indicates that the container has pending state that differs from
 	// the current.
@@ -51,6 +51,9 @@ typedef bool (*sway_scene_buffer_point_accepts_input_func_t)(
 typedef void (*sway_scene_buffer_iterator_func_t)(
 	struct sway_scene_buffer *buffer, int sx, int sy, void *user_data);
 
+// Number of descriptor slots per node, see sway/scene_descriptor.h
+#define SWAY_SCENE_NODE_DESCRIPTORS 8
+
 enum sway_scene_node_type {
 	SWAY_SCENE_NODE_TREE,
 	SWAY_SCENE_NODE_RECT,
@@ -76,6 +79,10 @@ struct sway_scene_node {
 
 	struct wlr_addon_set addons;
 
+	// Indexed by enum sway_scene_descriptor_type, looked up on every pointer
+	// motion and frame so they are kept out of the addon set
+	void *descriptors[SWAY_SCENE_NODE_DESCRIPTORS];
+
 	struct {
 		pixman_region32_t visible;
 	};
@@ -116,6 +123,11 @@ struct sway_scene {
 		bool direct_scanout;
 		bool calculate_visibility;
 		bool highlight_transparent_region;
+
+		// Bumped on every change that can alter the render lists of the
+		// outputs: node add/remove/reparent/enable/position/size, visibility
+		// and opaqueness. Buffer-only commits don't change it.
+		uint64_t render_list_serial;
 	};
 };
 
@@ -183,6 +195,9 @@ struct sway_scene_buffer {
 	struct sway_scene_output *primary_output;
 
 	float opacity;
+	// Set by the compositor once it applied the container alpha to the
+	// opacity, cleared when a surface commit resets the opacity
+	bool opacity_configured;
 	enum wlr_scale_filter_mode filter_mode;
 	struct wlr_fbox src_box;
 	int dst_width, dst_height;
@@ -251,6 +266,17 @@ struct sway_scene_output {
 		struct wl_list damage_highlight_regions;
 
 		struct wl_array render_list;
+		// The render list is retained between frames while the scene serial
+		// and the output geometry don't change
+		bool render_list_valid;
+		uint64_t render_list_serial;
+		struct wlr_box render_list_box;
+		float render_list_scale;
+		enum wl_output_transform render_list_transform;
+		bool render_list_calculate_visibility;
+		bool render_list_highlight_transparent_region;
+		// Opaque region of the render list entries, in buffer coordinates
+		pixman_region32_t render_list_opaque;
 
 		struct wlr_drm_syncobj_timeline *in_timeline;
 		uint64_t in_point;
@@ -607,6 +633,14 @@ void sway_scene_output_send_frame_done(struct sway_scene_output *scene_output,
  */
 void sway_scene_output_for_each_buffer(struct sway_scene_output *scene_output,
 	sway_scene_buffer_iterator_func_t iterator, void *user_data);
+/**
+ * Call `iterator` on each buffer of the render list retained from the last
+ * frame of the output, with the buffer's position in layout coordinates.
+ * Returns false without calling it when the scene or the output changed since,
+ * the caller then needs sway_scene_output_for_each_buffer().
+ */
+bool sway_scene_output_for_each_rendered_buffer(struct sway_scene_output *scene_output,
+	sway_scene_buffer_iterator_func_t iterator, void *user_data);
 /**
  * Get a scene-graph output from a struct wlr_output.
  *
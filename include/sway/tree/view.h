@@ -14,6 +14,7 @@
 
 struct sway_container;
 struct sway_xdg_decoration;
+struct criteria_cache;
 
 enum sway_view_type {
 	SWAY_VIEW_XDG_SHELL,
@@ -101,6 +102,7 @@ struct sway_view {
 	bool destroying;
 
 	list_t *executed_criteria; // struct criteria *
+	struct criteria_cache *criteria_cache;
 
 	union {
 		struct wlr_xdg_toplevel *wlr_xdg_toplevel;
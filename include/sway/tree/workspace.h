@@ -2,6 +2,7 @@
 #define _SWAY_WORKSPACE_H
 
 #include <stdbool.h>
+#include <time.h>
 #include "sway/config.h"
 #include "sway/tree/layout.h"
 #include "sway/tree/container.h"
@@ -53,6 +54,20 @@ struct sway_workspace {
 		double dx, dy;
 		struct sway_container *pin;
 		enum sway_layout_pin pin_position;
+		struct sway_seat *seat;
+
+		// Deltas accumulated since the last output frame, for the workspace
+		// and for the column under the cursor
+		bool pending;
+		double ws_dx, ws_dy;
+		struct sway_container *container;
+		double con_dx, con_dy;
+
+		// Kinetic scrolling: velocity in layout pixels per second
+		double vx, vy;
+		bool momentum_container; // the momentum scrolls the column
+		struct timespec last; // time of the last update or momentum step
+		bool momentum;
 	} gesture;
 
 	struct sway_workspace_state current;
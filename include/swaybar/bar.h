@@ -15,6 +15,7 @@ struct swaybar_tray;
 #endif
 struct swaybar_workspace;
 struct loop;
+struct json_tokener;
 
 struct swaybar {
 	char *id;
@@ -50,12 +51,14 @@ struct swaybar {
 	struct wl_shm *shm;
 
 	struct swaybar_config *config;
+	uint32_t config_serial; // bumped on every barconfig_update
 	struct status_line *status;
 
 	struct loop *eventloop;
 
 	int ipc_event_socketfd;
 	int ipc_socketfd;
+	struct json_tokener *ipc_tokener; // for events
 
 	struct wl_list outputs; // swaybar_output::link
 	struct wl_list unused_outputs; // swaybar_output::link
@@ -92,6 +95,14 @@ struct swaybar_output {
 	bool dirty;
 	bool frame_scheduled;
 
+	// Items drawn in the current buffer and a hash of everything else it
+	// depends on, so the next frame only redraws the items that changed
+	struct wl_array render_items; // struct render_item
+	uint32_t render_hash;
+	bool render_valid;
+	// Pixels of the items drawn in the last frame, see render.c
+	struct wl_array render_cache; // struct render_cache_entry
+
 	uint32_t output_height, output_width, output_x, output_y;
 };
 
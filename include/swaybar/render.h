@@ -4,5 +4,6 @@
 struct swaybar_output;
 
 void render_frame(struct swaybar_output *output);
+void render_cache_finish(struct swaybar_output *output);
 
 #endif
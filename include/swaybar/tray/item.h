@@ -31,6 +31,7 @@ struct swaybar_sni {
 	int min_size;
 	int max_size;
 	int target_size;
+	uint32_t icon_serial; // bumped whenever icon is replaced
 
 	// dbus properties
 	char *watcher_id;
@@ -10,6 +10,7 @@
 #include <basu/sd-bus.h>
 #endif
 #include <cairo.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include "swaybar/tray/host.h"
 #include "list.h"
@@ -37,6 +38,6 @@ struct swaybar_tray {
 struct swaybar_tray *create_tray(struct swaybar *bar);
 void destroy_tray(struct swaybar_tray *tray);
 void tray_in(int fd, short mask, void *data);
-uint32_t render_tray(cairo_t *cairo, struct swaybar_output *output, double *x);
+bool tray_shown_on_output(struct swaybar_output *output);
 
 #endif
@@ -8,6 +8,7 @@
 #include "sway/commands.h"
 #include "sway/config.h"
 #include "sway/criteria.h"
+#include "sway/desktop/transaction.h"
 #include "sway/input/input-manager.h"
 #include "sway/input/seat.h"
 #include "sway/tree/view.h"
@@ -78,6 +79,7 @@ static const struct cmd_handler handlers[] = {
 	{ "gaps", cmd_gaps },
 	{ "hide_edge_borders", cmd_hide_edge_borders },
 	{ "input", cmd_input },
+	{ "ipc_backlog_limit", cmd_ipc_backlog_limit },
 	{ "mode", cmd_mode },
 	{ "mouse_warping", cmd_mouse_warping },
 	{ "new_float", cmd_new_float },
@@ -111,6 +113,7 @@ static const struct cmd_handler config_handlers[] = {
 	{ "fullscreen_movefocus", cmd_fullscreen_movefocus },
 	{ "gesture_scroll_enable", cmd_gesture_scroll_enable },
 	{ "gesture_scroll_fingers", cmd_gesture_scroll_fingers },
+	{ "gesture_scroll_friction", cmd_gesture_scroll_friction },
 	{ "gesture_scroll_sensitivity", cmd_gesture_scroll_sensitivity },
 	{ "include", cmd_include },
 	{ "jump_labels_background", cmd_jump_labels_background },
@@ -120,6 +123,7 @@ static const struct cmd_handler config_handlers[] = {
 	{ "layout_default_height", cmd_layout_default_height },
 	{ "layout_default_width", cmd_layout_default_width },
 	{ "layout_heights", cmd_layout_heights },
+	{ "layout_offscreen_margin", cmd_layout_offscreen_margin },
 	{ "layout_widths", cmd_layout_widths },
 	{ "primary_selection", cmd_primary_selection },
 	{ "scrollnag_command", cmd_swaynag_command },
@@ -228,88 +232,227 @@ static void set_config_node(struct sway_node *node, bool node_overridden) {
 	}
 }
 
-list_t *execute_command(char *_exec, struct sway_seat *seat,
-		struct sway_container *con) {
-	char *cmd;
-	char matched_delim = ';';
-	list_t *containers = NULL;
-	bool using_criteria = false;
+/**
+ * One command of a command list, split and looked up ahead of time.
+ */
+struct cmd_program_step {
+	// Set on the first command after a ';', which drops the criteria of the
+	// previous commands
+	bool new_list;
+	// Criteria the command list starts with, if any. Criteria resolving
+	// __focused__ are parsed again each time the program runs.
+	char *criteria_raw;
+	struct criteria *criteria;
+
+	char *command; // NULL for an empty command
+	int argc;
+	char **argv;
+	const struct cmd_handler *handler;
+	bool expand; // some argument refers to a variable
+	char *error; // the program stops here
+};
 
-	if (seat == NULL) {
-		// passing a NULL seat means we just pick the default seat
-		seat = input_manager_get_default_seat();
-		if (!sway_assert(seat, "could not find a seat to run the command on")) {
-			return NULL;
-		}
+struct cmd_program {
+	list_t *steps; // struct cmd_program_step
+	// A command can free the binding running it, so each run holds a
+	// reference until it is done
+	int refs;
+	bool failed; // some step is an error
+};
+
+static void cmd_program_step_destroy(struct cmd_program_step *step) {
+	free(step->criteria_raw);
+	if (step->criteria) {
+		criteria_destroy(step->criteria);
+	}
+	free(step->command);
+	if (step->argv) {
+		free_argv(step->argc, step->argv);
 	}
+	free(step->error);
+	free(step);
+}
 
-	char *exec = strdup(_exec);
-	char *head = exec;
-	list_t *res_list = create_list();
+void cmd_program_destroy(struct cmd_program *program) {
+	if (!program || --program->refs > 0) {
+		return;
+	}
+	for (int i = 0; i < program->steps->length; ++i) {
+		cmd_program_step_destroy(program->steps->items[i]);
+	}
+	list_free(program->steps);
+	free(program);
+}
 
-	if (!res_list || !exec) {
+struct cmd_program *cmd_program_compile(const char *command) {
+	struct cmd_program *program = calloc(1, sizeof(*program));
+	char *exec = strdup(command);
+	if (!program || !exec || !(program->steps = create_list())) {
+		free(program);
+		free(exec);
 		return NULL;
 	}
+	program->refs = 1;
 
-	config->handler_context.seat = seat;
-
+	char *head = exec;
+	char matched_delim = ';';
 	do {
+		struct cmd_program_step *step = calloc(1, sizeof(*step));
+		if (!step) {
+			cmd_program_destroy(program);
+			program = NULL;
+			break;
+		}
+		list_add(program->steps, step);
+
 		for (; isspace(*head); ++head) {}
 		// Extract criteria (valid for this command list only).
 		if (matched_delim == ';') {
-			using_criteria = false;
+			step->new_list = true;
 			if (*head == '[') {
-				char *error = NULL;
-				struct criteria *criteria = criteria_parse(head, &error);
+				struct criteria *criteria = criteria_parse(head, &step->error);
 				if (!criteria) {
-					list_add(res_list,
-							cmd_results_new(CMD_INVALID, "%s", error));
-					free(error);
-					goto cleanup;
+					program->failed = true;
+					break;
 				}
-				list_free(containers);
-				containers = criteria_get_containers(criteria);
+				step->criteria_raw = strdup(criteria->raw);
 				head += strlen(criteria->raw);
-				criteria_destroy(criteria);
-				using_criteria = true;
+				if (strstr(criteria->raw, "__focused__")) {
+					criteria_destroy(criteria);
+				} else {
+					step->criteria = criteria;
+				}
 				// Skip leading whitespace
 				for (; isspace(*head); ++head) {}
 			}
 		}
 		// Split command list
-		cmd = argsep(&head, ";,", &matched_delim);
+		char *cmd = argsep(&head, ";,", &matched_delim);
 		for (; isspace(*cmd); ++cmd) {}
 
 		if (strcmp(cmd, "") == 0) {
 			sway_log(SWAY_INFO, "Ignoring empty command.");
 			continue;
 		}
-		sway_log(SWAY_INFO, "Handling command '%s'", cmd);
+		step->command = strdup(cmd);
 		//TODO better handling of argv
-		int argc;
-		char **argv = split_args(cmd, &argc);
+		step->argv = split_args(cmd, &step->argc);
+		char **argv = step->argv;
 		if (strcmp(argv[0], "exec") != 0 &&
 				strcmp(argv[0], "exec_always") != 0 &&
 				strcmp(argv[0], "mode") != 0) {
-			for (int i = 1; i < argc; ++i) {
+			for (int i = 1; i < step->argc; ++i) {
 				if (*argv[i] == '\"' || *argv[i] == '\'') {
 					strip_quotes(argv[i]);
 				}
 			}
 		}
-		const struct cmd_handler *handler = find_core_handler(argv[0]);
-		if (!handler) {
-			list_add(res_list, cmd_results_new(CMD_INVALID,
-					"Unknown/invalid command '%s'", argv[0]));
-			free_argv(argc, argv);
-			goto cleanup;
+		step->handler = find_core_handler(argv[0]);
+		if (!step->handler) {
+			step->error = format_str("Unknown/invalid command '%s'", argv[0]);
+			program->failed = true;
+			break;
+		}
+
+		// Var replacement, for all but first argument of set. Variables are
+		// replaced when the program runs, so it sees the current values.
+		for (int i = step->handler->handle == cmd_set ? 2 : 1;
+				i < step->argc; ++i) {
+			if (strchr(argv[i], '$')) {
+				step->expand = true;
+			}
 		}
+	} while(head);
 
-		// Var replacement, for all but first argument of set
-		for (int i = handler->handle == cmd_set ? 2 : 1; i < argc; ++i) {
+	free(exec);
+	return program;
+}
+
+static char **cmd_program_step_argv(struct cmd_program_step *step) {
+	// Handlers are free to modify their arguments
+	char **argv = calloc(step->argc + 1, sizeof(char *));
+	if (!argv) {
+		return NULL;
+	}
+	for (int i = 0; i < step->argc; ++i) {
+		argv[i] = strdup(step->argv[i]);
+	}
+	if (step->expand) {
+		for (int i = step->handler->handle == cmd_set ? 2 : 1;
+				i < step->argc; ++i) {
 			argv[i] = do_var_replacement(argv[i]);
 		}
+	}
+	return argv;
+}
+
+list_t *cmd_program_run(struct cmd_program *program, struct sway_seat *seat,
+		struct sway_container *con) {
+	list_t *containers = NULL;
+	bool using_criteria = false;
+
+	if (seat == NULL) {
+		// passing a NULL seat means we just pick the default seat
+		seat = input_manager_get_default_seat();
+		if (!sway_assert(seat, "could not find a seat to run the command on")) {
+			return NULL;
+		}
+	}
 
+	list_t *res_list = create_list();
+	if (!res_list) {
+		return NULL;
+	}
+
+	config->handler_context.seat = seat;
+	program->refs++;
+	// Commands commit their changes as they go, the whole list is committed
+	// as one transaction once it is done
+	transaction_batch_begin();
+
+	for (int s = 0; s < program->steps->length; ++s) {
+		struct cmd_program_step *step = program->steps->items[s];
+		if (step->new_list) {
+			using_criteria = false;
+		}
+		if (step->criteria_raw) {
+			struct criteria *criteria = step->criteria;
+			if (!criteria) {
+				char *error = NULL;
+				criteria = criteria_parse(step->criteria_raw, &error);
+				if (!criteria) {
+					list_add(res_list,
+							cmd_results_new(CMD_INVALID, "%s", error));
+					free(error);
+					goto cleanup;
+				}
+			}
+			list_free(containers);
+			containers = criteria_get_containers(criteria);
+			if (criteria != step->criteria) {
+				criteria_destroy(criteria);
+			}
+			using_criteria = true;
+		}
+		if (step->command) {
+			sway_log(SWAY_INFO, "Handling command '%s'", step->command);
+		}
+		if (step->error) {
+			list_add(res_list, cmd_results_new(CMD_INVALID, "%s", step->error));
+			goto cleanup;
+		}
+		if (!step->handler) {
+			continue;
+		}
+
+		const struct cmd_handler *handler = step->handler;
+		int argc = step->argc;
+		char **argv = cmd_program_step_argv(step);
+		if (!argv) {
+			list_add(res_list, cmd_results_new(CMD_FAILURE,
+					"Unable to allocate command arguments"));
+			goto cleanup;
+		}
 
 		if (!using_criteria) {
 			if (con) {
@@ -352,13 +495,49 @@ list_t *execute_command(char *_exec, struct sway_seat *seat,
 					fail_res ? fail_res : cmd_results_new(CMD_SUCCESS, NULL));
 		}
 		free_argv(argc, argv);
-	} while(head);
+	}
 cleanup:
-	free(exec);
+	transaction_batch_end();
 	list_free(containers);
+	cmd_program_destroy(program);
+	return res_list;
+}
+
+list_t *execute_command(char *_exec, struct sway_seat *seat,
+		struct sway_container *con) {
+	struct cmd_program *program = cmd_program_compile(_exec);
+	if (!program) {
+		return NULL;
+	}
+	list_t *res_list = cmd_program_run(program, seat, con);
+	cmd_program_destroy(program);
 	return res_list;
 }
 
+list_t *execute_command_program(struct cmd_program **program, char *command,
+		struct sway_seat *seat, struct sway_container *con) {
+	// Handlers are looked up by the context the program is compiled in, only
+	// keep those compiled at runtime
+	if (config->reading || !config->active) {
+		return execute_command(command, seat, con);
+	}
+	if (!*program) {
+		struct cmd_program *compiled = cmd_program_compile(command);
+		if (!compiled) {
+			return NULL;
+		}
+		if (compiled->failed) {
+			// Errors may depend on the state at the time, e.g. criteria on
+			// the focused container, so these are parsed on every run
+			list_t *res_list = cmd_program_run(compiled, seat, con);
+			cmd_program_destroy(compiled);
+			return res_list;
+		}
+		*program = compiled;
+	}
+	return cmd_program_run(*program, seat, con);
+}
+
 // this is like execute_command above, except:
 // 1) it ignores empty commands (empty lines)
 // 2) it does variable substitution
@@ -8,6 +8,7 @@
 static const struct cmd_handler animations_config_handlers[] = {
 	{ "default", animations_cmd_default },
 	{ "enabled", animations_cmd_enabled },
+	{ "frame_clock", animations_cmd_frame_clock },
 	{ "frequency_ms", animations_cmd_frequency },
 	{ "window_move", animations_cmd_window_move },
 	{ "window_open", animations_cmd_window_open },
@@ -23,6 +24,15 @@ struct cmd_results *animations_cmd_enabled(int argc, char **argv) {
 	return cmd_results_new(CMD_SUCCESS, NULL);
 }
 
+struct cmd_results *animations_cmd_frame_clock(int argc, char **argv) {
+	struct cmd_results *error = NULL;
+	if ((error = checkarg(argc, "frame_clock", EXPECTED_AT_LEAST, 1))) {
+		return error;
+	}
+	config->animations.frame_clock = parse_boolean(argv[0], config->animations.frame_clock);
+	return cmd_results_new(CMD_SUCCESS, NULL);
+}
+
 struct cmd_results *animations_cmd_frequency(int argc, char **argv) {
 	struct cmd_results *error = NULL;
 	if ((error = checkarg(argc, "frequency_ms", EXPECTED_AT_LEAST, 1))) {
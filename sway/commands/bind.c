@@ -27,6 +27,7 @@ void free_sway_binding(struct sway_binding *binding) {
 	list_free_items_and_destroy(binding->syms);
 	free(binding->input);
 	free(binding->command);
+	cmd_program_destroy(binding->program);
 	free(binding);
 }
 
@@ -35,6 +36,7 @@ void free_switch_binding(struct sway_switch_binding *binding) {
 		return;
 	}
 	free(binding->command);
+	cmd_program_destroy(binding->program);
 	free(binding);
 }
 
@@ -481,6 +483,7 @@ static struct cmd_results *cmd_bindsym_or_bindcode(int argc, char **argv,
 		mode_bindings = config->current_mode->mouse_bindings;
 	}
 
+	binding_index_invalidate(config->current_mode);
 	if (unbind) {
 		return binding_remove(binding, mode_bindings, bindtype, argv[0]);
 	}
@@ -600,6 +603,11 @@ struct cmd_results *cmd_unbindswitch(int argc, char **argv) {
  * Execute the command associated to a binding
  */
 void seat_execute_command(struct sway_seat *seat, struct sway_binding *binding) {
+	seat_execute_binding_command(seat, binding, &binding->program);
+}
+
+void seat_execute_binding_command(struct sway_seat *seat,
+		struct sway_binding *binding, struct cmd_program **program) {
 	if (!config->active) {
 		sway_log(SWAY_DEBUG, "deferring command for binding: %s",
 				binding->command);
@@ -610,6 +618,7 @@ void seat_execute_command(struct sway_seat *seat, struct sway_binding *binding)
 		}
 		memcpy(deferred, binding, sizeof(struct sway_binding));
 		deferred->command = binding->command ? strdup(binding->command) : NULL;
+		deferred->program = NULL;
 		list_add(seat->deferred_bindings, deferred);
 		return;
 	}
@@ -628,7 +637,8 @@ void seat_execute_command(struct sway_seat *seat, struct sway_binding *binding)
 		}
 	}
 
-	list_t *res_list = execute_command(binding->command, seat, con);
+	list_t *res_list = execute_command_program(program,
+			binding->command, seat, con);
 	bool success = true;
 	for (int i = 0; i < res_list->length; ++i) {
 		struct cmd_results *results = res_list->items[i];
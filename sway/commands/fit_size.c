@@ -155,7 +155,7 @@ static void fit_size_workspace(struct sway_workspace *workspace, enum sway_layou
 		return;
 	}
 	int from, to;
-	int active_idx = max(list_find(workspace->tiling, workspace->current.focused_inactive_child), 0);
+	int active_idx = max(list_find(workspace->tiling, layout_get_active_child(&workspace->node)), 0);
 	float scale = layout_scale_enabled(workspace) ? layout_scale_get(workspace) : 1.0f;
 	enum sway_container_layout layout = layout_get_type(workspace);
 
@@ -239,7 +239,7 @@ static void fit_size_container(struct sway_container *container, enum sway_layou
 		return;
 	}
 	int from, to;
-	int active_idx = max(list_find(children, container->current.focused_inactive_child), 0);
+	int active_idx = max(list_find(children, layout_get_active_child(&container->node)), 0);
 	struct sway_workspace * workspace = container->pending.workspace;
 	float scale = layout_scale_enabled(workspace) ? layout_scale_get(workspace) : 1.0f;
 	enum sway_container_layout layout = container->pending.layout;
@@ -12,6 +12,7 @@ void free_gesture_binding(struct sway_gesture_binding *binding) {
 	}
 	free(binding->input);
 	free(binding->command);
+	cmd_program_destroy(binding->program);
 	free(binding);
 }
 
@@ -192,6 +193,26 @@ struct cmd_results *cmd_gesture_scroll_fingers(int argc, char **argv) {
 	return cmd_results_new(CMD_SUCCESS, NULL);
 }
 
+/**
+ * Set the friction of kinetic gesture scrolling in config
+ */
+struct cmd_results *cmd_gesture_scroll_friction(int argc, char **argv) {
+	struct cmd_results *error = NULL;
+	if ((error = checkarg(argc, "gesture_scroll_friction", EXPECTED_AT_LEAST, 1))) {
+		return error;
+	}
+
+	char *end;
+	float friction = strtof(argv[0], &end);
+	if (*end || friction < 0.0f) {
+		return cmd_results_new(CMD_INVALID,
+			"gesture_scroll_friction expects a non-negative number");
+	}
+	config->gesture_scroll_friction = friction;
+
+	return cmd_results_new(CMD_SUCCESS, NULL);
+}
+
 /**
  * Set the sensitivity value for gesture scrolling in config
  */
@@ -0,0 +1,20 @@
+#include <stdlib.h>
+#include "sway/commands.h"
+#include "sway/config.h"
+
+struct cmd_results *cmd_ipc_backlog_limit(int argc, char **argv) {
+	struct cmd_results *error = NULL;
+	if ((error = checkarg(argc, "ipc_backlog_limit", EXPECTED_EQUAL_TO, 1))) {
+		return error;
+	}
+
+	char *inv;
+	long value = strtol(argv[0], &inv, 10);
+	if (*inv != '\0' || value <= 0 || value > 4096) {
+		return cmd_results_new(CMD_INVALID, "Invalid backlog limit specified");
+	}
+
+	config->ipc_backlog_limit = (size_t)value * 1024 * 1024;
+
+	return cmd_results_new(CMD_SUCCESS, NULL);
+}
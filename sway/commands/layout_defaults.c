@@ -24,6 +24,25 @@ struct cmd_results *cmd_layout_default_width(int argc, char **argv) {
 	return cmd_results_new(CMD_SUCCESS, NULL);
 }
 
+struct cmd_results *cmd_layout_offscreen_margin(int argc, char **argv) {
+	struct cmd_results *error;
+	if ((error = checkarg(argc, "layout_offscreen_margin", EXPECTED_EQUAL_TO, 1))) {
+		return error;
+	}
+	if (strcasecmp(argv[0], "off") == 0) {
+		config->layout_offscreen_margin = -1;
+		return cmd_results_new(CMD_SUCCESS, NULL);
+	}
+	char *inv;
+	long value = strtol(argv[0], &inv, 10);
+	if (*inv != '\0' || value < 0 || value > INT_MAX) {
+		return cmd_results_new(CMD_INVALID,
+			"Expected 'layout_offscreen_margin <pixels|off>'");
+	}
+	config->layout_offscreen_margin = value;
+	return cmd_results_new(CMD_SUCCESS, NULL);
+}
+
 struct cmd_results *cmd_layout_heights(int argc, char **argv) {
 	struct cmd_results *error;
 	if ((error = checkarg(argc, "layout_heights", EXPECTED_AT_LEAST, 1))) {
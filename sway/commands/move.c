@@ -312,7 +312,12 @@ static struct cmd_results *cmd_move_container(bool no_auto_back_and_forth,
 			return cmd_results_new(CMD_FAILURE,
 				"Can't find output with name/direction '%s'", argv[1]);
 		}
-		destination = &new_output->current.active_workspace->node;
+		struct sway_workspace *ws = output_get_active_workspace(new_output);
+		if (!ws) {
+			return cmd_results_new(CMD_FAILURE,
+				"Output '%s' has no workspace", argv[1]);
+		}
+		destination = &ws->node;
 	} else if (strcasecmp(argv[0], "mark") == 0) {
 		struct sway_container *dest_con = container_find_mark(argv[1]);
 		if (dest_con == NULL) {
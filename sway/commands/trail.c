@@ -20,19 +20,20 @@ struct cmd_results *cmd_trailmark(int argc, char **argv) {
 
 	if (strcasecmp(argv[0], "toggle") == 0) {
 		struct sway_container *con = config->handler_context.container;
-		struct sway_view *view;
-		if (con->view) {
-			view = con->view;
-		} else {
-			con = con->current.focused_inactive_child;
-			if (con) {
-				view = con->view;
-			} else {
-				con = con->current.children->items[0];
-				view = con->view;
+		if (!con) {
+			return cmd_results_new(CMD_FAILURE, "No container to trailmark");
+		}
+		if (!con->view) {
+			struct sway_container *active = layout_get_active_child(&con->node);
+			if (!active && con->pending.children->length > 0) {
+				active = con->pending.children->items[0];
+			}
+			if (!active || !active->view) {
+				return cmd_results_new(CMD_FAILURE, "No view to trailmark");
 			}
+			con = active;
 		}
-		layout_trailmark_toggle(view);
+		layout_trailmark_toggle(con->view);
 	} else if (strcasecmp(argv[0], "next") == 0) {
 		layout_trailmark_next();
 	} else if (strcasecmp(argv[0], "prev") == 0) {
@@ -79,6 +79,8 @@ static void free_mode(struct sway_mode *mode) {
 		}
 		list_free(mode->keycode_bindings);
 	}
+	binding_index_finish(&mode->keysym_index);
+	binding_index_finish(&mode->keycode_index);
 	if (mode->mouse_bindings) {
 		for (int i = 0; i < mode->mouse_bindings->length; i++) {
 			free_sway_binding(mode->mouse_bindings->items[i]);
@@ -165,6 +167,7 @@ void free_config(struct sway_config *config) {
 			criteria_destroy(config->criteria->items[i]);
 		}
 		list_free(config->criteria);
+		criteria_invalidate();
 	}
 
 	if (config->animations.anim_default) {
@@ -256,6 +259,7 @@ static void config_defaults(struct sway_config *config) {
 		*val = sizes[i];
 		list_add(config->layout_heights, val);
 	}
+	config->layout_offscreen_margin = -1;
 	color_to_rgba(config->jump_labels_color, 0x159E3080);
 	color_to_rgba(config->jump_labels_background, 0x00000000);
 	config->jump_labels_scale = 0.5;
@@ -264,9 +268,11 @@ static void config_defaults(struct sway_config *config) {
 	config->gesture_scroll_enable = true;
 	config->gesture_scroll_fingers = 3;
 	config->gesture_scroll_sentitivity = 1.0f;
+	config->gesture_scroll_friction = 0.0f;
 
 	config->animations.frequency_ms = 16; // ~60 Hz
 	config->animations.enabled = true;
+	config->animations.frame_clock = false;
 	double points[] = { 0.215, 0.61, 0.355, 1.0 };
 	list_t *default_points = create_list();
 	for (uint32_t i = 0; i < sizeof(points) / sizeof(double); ++i) {
@@ -285,7 +291,7 @@ static void config_defaults(struct sway_config *config) {
 
 	if (!(config->cmd_queue = create_list())) goto cleanup;
 
-	if (!(config->current_mode = malloc(sizeof(struct sway_mode))))
+	if (!(config->current_mode = calloc(1, sizeof(struct sway_mode))))
 		goto cleanup;
 	if (!(config->current_mode->name = malloc(sizeof("default")))) goto cleanup;
 	strcpy(config->current_mode->name, "default");
@@ -338,6 +344,7 @@ static void config_defaults(struct sway_config *config) {
 	config->title_align = ALIGN_LEFT;
 	config->tiling_drag = true;
 	config->tiling_drag_threshold = 9;
+	config->ipc_backlog_limit = 4 * 1024 * 1024;
 	config->primary_selection = true;
 
 	config->smart_gaps = SMART_GAPS_OFF;
@@ -1086,6 +1093,7 @@ void translate_keysyms(struct input_config *input_config) {
 
 		mode->keysym_bindings = bindsyms;
 		mode->keycode_bindings = bindcodes;
+		binding_index_invalidate(mode);
 	}
 
 	sway_log(SWAY_DEBUG, "Translated keysyms using config for device '%s'",
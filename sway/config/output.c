@@ -1,8 +1,12 @@
 #include <assert.h>
 #include <drm_fourcc.h>
+#include <errno.h>
+#include <inttypes.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #include <wlr/config.h>
@@ -22,6 +26,7 @@
 #include "sway/tree/arrange.h"
 #include "sway/tree/root.h"
 #include "log.h"
+#include "stringop.h"
 #include "util.h"
 
 #if WLR_HAS_DRM_BACKEND
@@ -920,6 +925,434 @@ static void sort_output_configs_by_priority(
 	qsort(configs, configs_len, sizeof(*configs), compare_matched_output_config_priority);
 }
 
+/**
+ * The parts of an output state which the fallback search resolves.
+ */
+struct output_state_summary {
+	uint32_t committed; // WLR_OUTPUT_STATE_* bits of the fields below
+	bool enabled;
+	uint32_t render_format;
+	bool custom_mode;
+	int32_t width, height, refresh;
+	bool adaptive_sync;
+	float scale;
+};
+
+struct output_state_memo_output {
+	char identifier[128];
+	struct output_state_summary requested;
+	struct output_state_summary resolved;
+};
+
+/**
+ * A known-good result of the fallback search for a set of connected outputs
+ * and the states requested for them. Memos are kept in most recently used
+ * order and persisted to the state file, so the search can be skipped after
+ * hotplug, resume and cold boot when the requested states still fail.
+ */
+struct output_state_memo {
+	struct wl_list link;
+	size_t outputs_len;
+	struct output_state_memo_output *outputs;
+};
+
+#define OUTPUT_STATE_MEMO_MAX 16
+#define OUTPUT_STATE_SUMMARY_FIELDS 9
+
+static struct wl_list output_state_memos;
+static bool output_state_memos_loaded = false;
+
+static const uint32_t output_state_summary_fields =
+	WLR_OUTPUT_STATE_ENABLED | WLR_OUTPUT_STATE_RENDER_FORMAT |
+	WLR_OUTPUT_STATE_MODE | WLR_OUTPUT_STATE_ADAPTIVE_SYNC_ENABLED |
+	WLR_OUTPUT_STATE_SCALE;
+
+static void summarize_output_state(const struct wlr_output_state *state,
+		struct output_state_summary *summary) {
+	*summary = (struct output_state_summary){
+		.committed = state->committed & output_state_summary_fields,
+		.enabled = state->enabled,
+		.render_format = state->render_format,
+		.adaptive_sync = state->adaptive_sync_enabled,
+		.scale = state->scale,
+	};
+	if (state->committed & WLR_OUTPUT_STATE_MODE) {
+		if (state->mode_type == WLR_OUTPUT_STATE_MODE_CUSTOM) {
+			summary->custom_mode = true;
+			summary->width = state->custom_mode.width;
+			summary->height = state->custom_mode.height;
+			summary->refresh = state->custom_mode.refresh;
+		} else {
+			summary->width = state->mode->width;
+			summary->height = state->mode->height;
+			summary->refresh = state->mode->refresh;
+		}
+	}
+}
+
+static bool output_state_summary_equal(const struct output_state_summary *a,
+		const struct output_state_summary *b) {
+	return a->committed == b->committed && a->enabled == b->enabled &&
+		a->render_format == b->render_format &&
+		a->custom_mode == b->custom_mode && a->width == b->width &&
+		a->height == b->height && a->refresh == b->refresh &&
+		a->adaptive_sync == b->adaptive_sync && a->scale == b->scale;
+}
+
+/**
+ * An output that had to be turned off may only have failed for a transient
+ * reason, like link training, so such results are not remembered.
+ */
+static bool output_state_summary_disables(
+		const struct output_state_summary *requested,
+		const struct output_state_summary *resolved) {
+	bool requested_on = !(requested->committed & WLR_OUTPUT_STATE_ENABLED) ||
+		requested->enabled;
+	bool resolved_off = (resolved->committed & WLR_OUTPUT_STATE_ENABLED) &&
+		!resolved->enabled;
+	return requested_on && resolved_off;
+}
+
+static bool restore_output_state(struct wlr_output *wlr_output,
+		struct wlr_output_state *state,
+		const struct output_state_summary *summary) {
+	if ((summary->committed & WLR_OUTPUT_STATE_ENABLED) && !summary->enabled) {
+		reset_output_state(state);
+		wlr_output_state_set_enabled(state, false);
+		return true;
+	}
+
+	if (summary->committed & WLR_OUTPUT_STATE_MODE) {
+		if (summary->custom_mode) {
+			wlr_output_state_set_custom_mode(state, summary->width,
+				summary->height, summary->refresh);
+		} else {
+			struct wlr_output_mode *mode, *found = NULL;
+			wl_list_for_each(mode, &wlr_output->modes, link) {
+				if (mode->width == summary->width &&
+						mode->height == summary->height &&
+						mode->refresh == summary->refresh) {
+					found = mode;
+					break;
+				}
+			}
+			if (!found) {
+				return false;
+			}
+			wlr_output_state_set_mode(state, found);
+		}
+	} else {
+		state->committed &= ~WLR_OUTPUT_STATE_MODE;
+	}
+
+	if (summary->committed & WLR_OUTPUT_STATE_RENDER_FORMAT) {
+		wlr_output_state_set_render_format(state, summary->render_format);
+	}
+	if (summary->committed & WLR_OUTPUT_STATE_ADAPTIVE_SYNC_ENABLED) {
+		wlr_output_state_set_adaptive_sync_enabled(state,
+			summary->adaptive_sync);
+	} else {
+		state->committed &= ~WLR_OUTPUT_STATE_ADAPTIVE_SYNC_ENABLED;
+	}
+	if (summary->committed & WLR_OUTPUT_STATE_SCALE) {
+		wlr_output_state_set_scale(state, summary->scale);
+	}
+	return true;
+}
+
+static void output_state_memo_destroy(struct output_state_memo *memo) {
+	wl_list_remove(&memo->link);
+	free(memo->outputs);
+	free(memo);
+}
+
+static char *output_state_memo_path(void) {
+	const char *state_home = getenv("XDG_STATE_HOME");
+	if (state_home && state_home[0]) {
+		return format_str("%s/scroll/outputs", state_home);
+	}
+	const char *home = getenv("HOME");
+	if (!home || !home[0]) {
+		return NULL;
+	}
+	return format_str("%s/.local/state/scroll/outputs", home);
+}
+
+static bool parse_output_state_summary(char *str,
+		struct output_state_summary *summary) {
+	int enabled = 0, custom_mode = 0, adaptive_sync = 0;
+	int n = sscanf(str, "%" SCNx32 " %d %" SCNx32 " %d %" SCNd32 " %" SCNd32
+		" %" SCNd32 " %d %f", &summary->committed, &enabled,
+		&summary->render_format, &custom_mode, &summary->width,
+		&summary->height, &summary->refresh, &adaptive_sync, &summary->scale);
+	summary->enabled = enabled;
+	summary->custom_mode = custom_mode;
+	summary->adaptive_sync = adaptive_sync;
+	return n == OUTPUT_STATE_SUMMARY_FIELDS;
+}
+
+static void write_output_state_summary(FILE *f,
+		const struct output_state_summary *summary) {
+	fprintf(f, "\t%" PRIx32 " %d %" PRIx32 " %d %" PRId32 " %" PRId32
+		" %" PRId32 " %d %a", summary->committed, summary->enabled,
+		summary->render_format, summary->custom_mode, summary->width,
+		summary->height, summary->refresh, summary->adaptive_sync,
+		summary->scale);
+}
+
+/**
+ * Each line of the state file holds one memo: the number of outputs followed
+ * by the identifier, requested and resolved state of each, separated by tabs.
+ */
+static void load_output_state_memos(void) {
+	output_state_memos_loaded = true;
+	wl_list_init(&output_state_memos);
+
+	char *path = output_state_memo_path();
+	FILE *f = path ? fopen(path, "r") : NULL;
+	free(path);
+	if (!f) {
+		return;
+	}
+
+	char *line = NULL;
+	size_t line_size = 0;
+	int count = 0;
+	while (getline(&line, &line_size, f) != -1 &&
+			count < OUTPUT_STATE_MEMO_MAX) {
+		line[strcspn(line, "\n")] = '\0';
+		char *cursor = line;
+		char *field = strsep(&cursor, "\t");
+		size_t outputs_len = strtoul(field, NULL, 10);
+		if (outputs_len == 0 || outputs_len > 64) {
+			continue;
+		}
+		struct output_state_memo *memo = calloc(1, sizeof(*memo));
+		if (!memo) {
+			break;
+		}
+		memo->outputs = calloc(outputs_len, sizeof(*memo->outputs));
+		if (!memo->outputs) {
+			free(memo);
+			break;
+		}
+		memo->outputs_len = outputs_len;
+		wl_list_insert(output_state_memos.prev, &memo->link);
+
+		bool valid = true;
+		for (size_t i = 0; i < outputs_len && valid; i++) {
+			struct output_state_memo_output *out = &memo->outputs[i];
+			char *identifier = strsep(&cursor, "\t");
+			char *requested = strsep(&cursor, "\t");
+			char *resolved = strsep(&cursor, "\t");
+			valid = identifier && requested && resolved &&
+				parse_output_state_summary(requested, &out->requested) &&
+				parse_output_state_summary(resolved, &out->resolved);
+			if (valid) {
+				snprintf(out->identifier, sizeof(out->identifier), "%s",
+					identifier);
+			}
+		}
+		if (!valid) {
+			output_state_memo_destroy(memo);
+			continue;
+		}
+		count++;
+	}
+	free(line);
+	fclose(f);
+	sway_log(SWAY_DEBUG, "Loaded %d output state memos", count);
+}
+
+static bool mkdir_parents(char *path) {
+	for (char *slash = strchr(path + 1, '/'); slash;
+			slash = strchr(slash + 1, '/')) {
+		*slash = '\0';
+		bool ok = mkdir(path, 0755) == 0 || errno == EEXIST;
+		*slash = '/';
+		if (!ok) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void save_output_state_memos(void) {
+	char *path = output_state_memo_path();
+	if (!path) {
+		return;
+	}
+	char *tmp_path = format_str("%s.tmp", path);
+	if (!tmp_path || !mkdir_parents(path)) {
+		sway_log_errno(SWAY_ERROR, "Unable to create directory for %s", path);
+		goto out;
+	}
+
+	FILE *f = fopen(tmp_path, "w");
+	if (!f) {
+		sway_log_errno(SWAY_ERROR, "Unable to write %s", tmp_path);
+		goto out;
+	}
+	struct output_state_memo *memo;
+	wl_list_for_each(memo, &output_state_memos, link) {
+		fprintf(f, "%zu", memo->outputs_len);
+		for (size_t i = 0; i < memo->outputs_len; i++) {
+			struct output_state_memo_output *out = &memo->outputs[i];
+			fprintf(f, "\t%s", out->identifier);
+			write_output_state_summary(f, &out->requested);
+			write_output_state_summary(f, &out->resolved);
+		}
+		fprintf(f, "\n");
+	}
+	if (fclose(f) != 0 || rename(tmp_path, path) != 0) {
+		sway_log_errno(SWAY_ERROR, "Unable to write %s", path);
+		unlink(tmp_path);
+	}
+
+out:
+	free(tmp_path);
+	free(path);
+}
+
+/**
+ * Get the identifiers of the outputs, or return false if they can't serve as
+ * a memo key because they are not unique or not representable in the file.
+ */
+static bool get_memo_identifiers(struct matched_output_config *configs,
+		size_t configs_len, char (*identifiers)[128]) {
+	for (size_t idx = 0; idx < configs_len; idx++) {
+		output_get_identifier(identifiers[idx], sizeof(identifiers[idx]),
+			configs[idx].output);
+		if (strpbrk(identifiers[idx], "\t\n")) {
+			return false;
+		}
+		for (size_t prev = 0; prev < idx; prev++) {
+			if (strcmp(identifiers[prev], identifiers[idx]) == 0) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static struct output_state_memo_output *output_state_memo_get_output(
+		struct output_state_memo *memo, const char *identifier) {
+	for (size_t i = 0; i < memo->outputs_len; i++) {
+		if (strcmp(memo->outputs[i].identifier, identifier) == 0) {
+			return &memo->outputs[i];
+		}
+	}
+	return NULL;
+}
+
+static struct output_state_memo *output_state_memo_find(
+		char (*identifiers)[128], struct output_state_summary *requested,
+		size_t configs_len) {
+	if (!output_state_memos_loaded) {
+		load_output_state_memos();
+	}
+	struct output_state_memo *memo;
+	wl_list_for_each(memo, &output_state_memos, link) {
+		if (memo->outputs_len != configs_len) {
+			continue;
+		}
+		bool match = true;
+		for (size_t idx = 0; idx < configs_len && match; idx++) {
+			struct output_state_memo_output *out =
+				output_state_memo_get_output(memo, identifiers[idx]);
+			match = out &&
+				output_state_summary_equal(&out->requested, &requested[idx]) &&
+				!output_state_summary_disables(&out->requested, &out->resolved);
+		}
+		if (match) {
+			return memo;
+		}
+	}
+	return NULL;
+}
+
+static void output_state_memo_store(char (*identifiers)[128],
+		struct output_state_summary *requested,
+		struct wlr_backend_output_state *states, size_t configs_len) {
+	for (size_t idx = 0; idx < configs_len; idx++) {
+		struct output_state_summary resolved;
+		summarize_output_state(&states[idx].base, &resolved);
+		if (output_state_summary_disables(&requested[idx], &resolved)) {
+			sway_log(SWAY_DEBUG, "Not remembering output configuration "
+				"that disables %s", identifiers[idx]);
+			return;
+		}
+	}
+
+	struct output_state_memo *memo =
+		output_state_memo_find(identifiers, requested, configs_len);
+	if (!memo) {
+		memo = calloc(1, sizeof(*memo));
+		if (!memo) {
+			return;
+		}
+		memo->outputs = calloc(configs_len, sizeof(*memo->outputs));
+		if (!memo->outputs) {
+			free(memo);
+			return;
+		}
+		memo->outputs_len = configs_len;
+	} else {
+		wl_list_remove(&memo->link);
+	}
+	wl_list_insert(&output_state_memos, &memo->link);
+
+	for (size_t idx = 0; idx < configs_len; idx++) {
+		struct output_state_memo_output *out = &memo->outputs[idx];
+		memcpy(out->identifier, identifiers[idx], sizeof(out->identifier));
+		out->requested = requested[idx];
+		summarize_output_state(&states[idx].base, &out->resolved);
+	}
+
+	if (wl_list_length(&output_state_memos) > OUTPUT_STATE_MEMO_MAX) {
+		output_state_memo_destroy(wl_container_of(output_state_memos.prev,
+			memo, link));
+	}
+	save_output_state_memos();
+}
+
+/**
+ * Try the remembered result of an earlier search for the same outputs and
+ * requested states. On failure the requested states are queued again.
+ */
+static bool try_output_state_memo(struct output_state_memo *memo,
+		char (*identifiers)[128], struct wlr_output_swapchain_manager *swapchain_mgr,
+		struct matched_output_config *configs,
+		struct wlr_backend_output_state *states, size_t configs_len) {
+	bool ok = true;
+	for (size_t idx = 0; idx < configs_len && ok; idx++) {
+		struct output_state_memo_output *out =
+			output_state_memo_get_output(memo, identifiers[idx]);
+		ok = restore_output_state(states[idx].output, &states[idx].base,
+			&out->resolved);
+	}
+	if (ok) {
+		ok = wlr_output_swapchain_manager_prepare(swapchain_mgr, states,
+			configs_len);
+	}
+	if (ok) {
+		sway_log(SWAY_DEBUG, "Using remembered output configuration");
+		wl_list_remove(&memo->link);
+		wl_list_insert(&output_state_memos, &memo->link);
+		return true;
+	}
+
+	sway_log(SWAY_DEBUG, "Remembered output configuration failed, discarding");
+	output_state_memo_destroy(memo);
+	save_output_state_memos();
+	for (size_t idx = 0; idx < configs_len; idx++) {
+		reset_output_state(&states[idx].base);
+		queue_output_config(configs[idx].config, configs[idx].output,
+			&states[idx].base);
+	}
+	return false;
+}
+
 static bool apply_resolved_output_configs(struct matched_output_config *configs,
 		size_t configs_len, bool test_only, bool degrade_to_off) {
 	struct wlr_backend_output_state *states = calloc(configs_len, sizeof(*states));
@@ -942,8 +1375,36 @@ static bool apply_resolved_output_configs(struct matched_output_config *configs,
 	struct wlr_output_swapchain_manager swapchain_mgr;
 	wlr_output_swapchain_manager_init(&swapchain_mgr, server.backend);
 
+	// A test must answer for the requested states, so memos only serve commits
+	char (*identifiers)[128] = NULL;
+	struct output_state_summary *requested = NULL;
+	if (!test_only && configs_len > 0) {
+		identifiers = calloc(configs_len, sizeof(*identifiers));
+		requested = calloc(configs_len, sizeof(*requested));
+		if (!identifiers || !requested ||
+				!get_memo_identifiers(configs, configs_len, identifiers)) {
+			free(identifiers);
+			free(requested);
+			identifiers = NULL;
+			requested = NULL;
+		}
+	}
+	for (size_t idx = 0; requested && idx < configs_len; idx++) {
+		summarize_output_state(&states[idx].base, &requested[idx]);
+	}
+
+	bool remember = false;
 	bool ok = wlr_output_swapchain_manager_prepare(&swapchain_mgr, states, configs_len);
+	// Memos only stand in for the fallback search, the requested states
+	// always get the first chance
+	struct output_state_memo *memo = !ok && requested ?
+		output_state_memo_find(identifiers, requested, configs_len) : NULL;
+	if (memo) {
+		ok = try_output_state_memo(memo, identifiers, &swapchain_mgr,
+			configs, states, configs_len);
+	}
 	if (!ok) {
+		remember = requested != NULL;
 		sway_log(SWAY_ERROR, "Requested backend configuration failed, searching for valid fallbacks");
 		struct search_context ctx = {
 			.swapchain_mgr = &swapchain_mgr,
@@ -989,6 +1450,10 @@ static bool apply_resolved_output_configs(struct matched_output_config *configs,
 
 	sway_log(SWAY_DEBUG, "Commit of %zd outputs succeeded", configs_len);
 
+	if (remember) {
+		output_state_memo_store(identifiers, requested, states, configs_len);
+	}
+
 	wlr_output_swapchain_manager_apply(&swapchain_mgr);
 
 	for (size_t idx = 0; idx < configs_len; idx++) {
@@ -1012,6 +1477,8 @@ static bool apply_resolved_output_configs(struct matched_output_config *configs,
 	transaction_commit_dirty();
 
 out:
+	free(identifiers);
+	free(requested);
 	wlr_output_swapchain_manager_finish(&swapchain_mgr);
 	for (size_t idx = 0; idx < configs_len; idx++) {
 		struct wlr_backend_output_state *backend_state = &states[idx];
@@ -1,9 +1,12 @@
+#include <ctype.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
 #include <strings.h>
 #define PCRE2_CODE_UNIT_WIDTH 8
 #include <pcre2.h>
+#include "sway/commands.h"
 #include "sway/criteria.h"
 #include "sway/tree/container.h"
 #include "sway/config.h"
@@ -61,9 +64,67 @@ static bool generate_regex(pcre2_code **regex, char *value) {
 		return false;
 	}
 
+	// pcre2_match() uses the JIT code when available and falls back to the
+	// interpreter otherwise, so a failure here is not an error
+	errorcode = pcre2_jit_compile(*regex, PCRE2_JIT_COMPLETE);
+	if (errorcode < 0 && errorcode != PCRE2_ERROR_JIT_BADOPTION) {
+		sway_log(SWAY_DEBUG, "JIT compilation for '%s' failed: %d",
+				value, errorcode);
+	}
+
 	return true;
 }
 
+/**
+ * Record the literal text of a regex that is a plain string anchored at the
+ * start, and optionally at the end. Anything else is left to PCRE2 alone.
+ */
+static void pattern_extract_literal(struct pattern *pattern,
+		const char *value) {
+	if (value[0] != '^') {
+		return;
+	}
+	char *literal = malloc(strlen(value));
+	if (!literal) {
+		return;
+	}
+	size_t len = 0;
+	bool exact = false;
+	for (const char *p = value + 1; *p; ++p) {
+		if (*p == '\\') {
+			// Escaped punctuation is literal; \d, \b, \Q... are not
+			if (!p[1] || isalnum((unsigned char)p[1])) {
+				free(literal);
+				return;
+			}
+			literal[len++] = *++p;
+		} else if (*p == '$' && p[1] == '\0') {
+			exact = true;
+		} else if (strchr(".^$|?*+()[{", *p)) {
+			free(literal);
+			return;
+		} else {
+			literal[len++] = *p;
+		}
+	}
+	literal[len] = '\0';
+	pattern->literal = literal;
+	pattern->literal_len = len;
+	pattern->literal_exact = exact;
+}
+
+static bool pattern_literal_match(struct pattern *pattern, const char *value) {
+	size_t len = strlen(value);
+	if (pattern->literal_exact && len > 0 && value[len - 1] == '\n') {
+		--len; // $ also matches before a final newline
+	}
+	if (len < pattern->literal_len || (pattern->literal_exact &&
+			len != pattern->literal_len)) {
+		return false;
+	}
+	return memcmp(value, pattern->literal, pattern->literal_len) == 0;
+}
+
 static bool pattern_create(struct pattern **pattern, char *value) {
 	*pattern = calloc(1, sizeof(struct pattern));
 	if (!*pattern) {
@@ -77,6 +138,7 @@ static bool pattern_create(struct pattern **pattern, char *value) {
 		if (!generate_regex(&(*pattern)->regex, value)) {
 			return false;
 		};
+		pattern_extract_literal(*pattern, value);
 	}
 	return true;
 }
@@ -86,10 +148,20 @@ static void pattern_destroy(struct pattern *pattern) {
 		if (pattern->regex) {
 			pcre2_code_free(pattern->regex);
 		}
+		free(pattern->literal);
 		free(pattern);
 	}
 }
 
+// Bumped whenever criteria are removed from config->criteria, which
+// invalidates the per-view match caches and the dispatch index since they
+// refer to criteria by position. Appending needs no bump.
+static uint32_t criteria_serial = 1;
+
+void criteria_invalidate(void) {
+	criteria_serial++;
+}
+
 void criteria_destroy(struct criteria *criteria) {
 	pattern_destroy(criteria->title);
 	pattern_destroy(criteria->shell);
@@ -106,15 +178,486 @@ void criteria_destroy(struct criteria *criteria) {
 	pattern_destroy(criteria->sandbox_instance_id);
 	free(criteria->target);
 	free(criteria->cmdlist);
+	cmd_program_destroy(criteria->program);
 	free(criteria->raw);
 	free(criteria);
 }
 
 static int regex_cmp(const char *item, const pcre2_code *regex) {
-	pcre2_match_data *match_data = pcre2_match_data_create_from_pattern(regex, NULL);
-	int result = pcre2_match(regex, (PCRE2_SPTR)item, strlen(item), 0, 0, match_data, NULL);
-	pcre2_match_data_free(match_data);
-	return result;
+	// Only whether the pattern matches is of interest, so a single match data
+	// block with room for the whole match is shared by all patterns
+	static pcre2_match_data *match_data = NULL;
+	if (!match_data) {
+		match_data = pcre2_match_data_create(1, NULL);
+		if (!match_data) {
+			sway_log(SWAY_ERROR, "Failed to allocate regex match data");
+			return PCRE2_ERROR_NOMEMORY;
+		}
+	}
+	return pcre2_match(regex, (PCRE2_SPTR)item, strlen(item), 0, 0, match_data, NULL);
+}
+
+enum criteria_attr {
+	CRITERIA_ATTR_TITLE,
+	CRITERIA_ATTR_SHELL,
+	CRITERIA_ATTR_APP_ID,
+	CRITERIA_ATTR_SANDBOX_ENGINE,
+	CRITERIA_ATTR_SANDBOX_APP_ID,
+	CRITERIA_ATTR_SANDBOX_INSTANCE_ID,
+#if WLR_HAS_XWAYLAND
+	CRITERIA_ATTR_CLASS,
+	CRITERIA_ATTR_INSTANCE,
+	CRITERIA_ATTR_WINDOW_ROLE,
+#endif
+	CRITERIA_ATTR_COUNT,
+};
+
+enum criteria_cache_result {
+	CRITERIA_CACHE_UNKNOWN,
+	CRITERIA_CACHE_MATCH,
+	CRITERIA_CACHE_NO_MATCH,
+};
+
+/**
+ * Regex results of the criteria in config->criteria against the string
+ * attributes of a view. The results of an attribute are dropped when its
+ * value changes, so only the patterns on that attribute are evaluated again.
+ */
+struct criteria_cache {
+	uint32_t serial;
+	int capacity;
+	struct {
+		char *value;
+		uint8_t *results; // enum criteria_cache_result, by criteria index
+	} attrs[CRITERIA_ATTR_COUNT];
+};
+
+static const char *view_get_criteria_attr(struct sway_view *view,
+		enum criteria_attr attr) {
+	switch (attr) {
+	case CRITERIA_ATTR_TITLE:
+		return view_get_title(view);
+	case CRITERIA_ATTR_SHELL:
+		return view_get_shell(view);
+	case CRITERIA_ATTR_APP_ID:
+		return view_get_app_id(view);
+	case CRITERIA_ATTR_SANDBOX_ENGINE:
+		return view_get_sandbox_engine(view);
+	case CRITERIA_ATTR_SANDBOX_APP_ID:
+		return view_get_sandbox_app_id(view);
+	case CRITERIA_ATTR_SANDBOX_INSTANCE_ID:
+		return view_get_sandbox_instance_id(view);
+#if WLR_HAS_XWAYLAND
+	case CRITERIA_ATTR_CLASS:
+		return view_get_class(view);
+	case CRITERIA_ATTR_INSTANCE:
+		return view_get_instance(view);
+	case CRITERIA_ATTR_WINDOW_ROLE:
+		return view_get_window_role(view);
+#endif
+	case CRITERIA_ATTR_COUNT:
+		break;
+	}
+	return NULL;
+}
+
+void criteria_cache_destroy(struct criteria_cache *cache) {
+	if (!cache) {
+		return;
+	}
+	for (int i = 0; i < CRITERIA_ATTR_COUNT; ++i) {
+		free(cache->attrs[i].value);
+		free(cache->attrs[i].results);
+	}
+	free(cache);
+}
+
+/**
+ * Bring the cache of the view in line with its current attributes and with
+ * config->criteria. Returns NULL if the cache can't be used.
+ */
+static struct criteria_cache *criteria_cache_prepare(struct sway_view *view) {
+	struct criteria_cache *cache = view->criteria_cache;
+	if (!cache) {
+		cache = view->criteria_cache = calloc(1, sizeof(*cache));
+		if (!cache) {
+			sway_log(SWAY_ERROR, "Failed to allocate criteria cache");
+			return NULL;
+		}
+	}
+
+	int length = config->criteria->length;
+	if (cache->capacity < length) {
+		for (int i = 0; i < CRITERIA_ATTR_COUNT; ++i) {
+			uint8_t *results = realloc(cache->attrs[i].results, length);
+			if (!results) {
+				sway_log(SWAY_ERROR, "Failed to allocate criteria cache");
+				criteria_cache_destroy(cache);
+				view->criteria_cache = NULL;
+				return NULL;
+			}
+			memset(results + cache->capacity, CRITERIA_CACHE_UNKNOWN,
+					length - cache->capacity);
+			cache->attrs[i].results = results;
+		}
+		cache->capacity = length;
+	}
+
+	bool stale = cache->serial != criteria_serial;
+	cache->serial = criteria_serial;
+	for (int i = 0; i < CRITERIA_ATTR_COUNT; ++i) {
+		const char *value = view_get_criteria_attr(view, i);
+		char *cached = cache->attrs[i].value;
+		if (!stale && (value == cached ||
+				(value && cached && strcmp(value, cached) == 0))) {
+			continue;
+		}
+		free(cached);
+		cache->attrs[i].value = value ? strdup(value) : NULL;
+		if (cache->capacity > 0) {
+			memset(cache->attrs[i].results, CRITERIA_CACHE_UNKNOWN,
+					cache->capacity);
+		}
+	}
+	return cache;
+}
+
+static bool criteria_regex_match(struct criteria_cache *cache, int index,
+		enum criteria_attr attr, const char *value, struct pattern *pattern) {
+	if (!cache) {
+		return regex_cmp(value, pattern->regex) >= 0;
+	}
+	uint8_t *result = &cache->attrs[attr].results[index];
+	if (*result == CRITERIA_CACHE_UNKNOWN) {
+		*result = regex_cmp(value, pattern->regex) >= 0 ?
+			CRITERIA_CACHE_MATCH : CRITERIA_CACHE_NO_MATCH;
+	}
+	return *result == CRITERIA_CACHE_MATCH;
+}
+
+static struct pattern *criteria_get_pattern(struct criteria *criteria,
+		enum criteria_attr attr) {
+	switch (attr) {
+	case CRITERIA_ATTR_TITLE:
+		return criteria->title;
+	case CRITERIA_ATTR_SHELL:
+		return criteria->shell;
+	case CRITERIA_ATTR_APP_ID:
+		return criteria->app_id;
+	case CRITERIA_ATTR_SANDBOX_ENGINE:
+		return criteria->sandbox_engine;
+	case CRITERIA_ATTR_SANDBOX_APP_ID:
+		return criteria->sandbox_app_id;
+	case CRITERIA_ATTR_SANDBOX_INSTANCE_ID:
+		return criteria->sandbox_instance_id;
+#if WLR_HAS_XWAYLAND
+	case CRITERIA_ATTR_CLASS:
+		return criteria->class;
+	case CRITERIA_ATTR_INSTANCE:
+		return criteria->instance;
+	case CRITERIA_ATTR_WINDOW_ROLE:
+		return criteria->window_role;
+#endif
+	case CRITERIA_ATTR_COUNT:
+		break;
+	}
+	return NULL;
+}
+
+/**
+ * The attribute value as criteria_matches_view() tests it, or NULL if no
+ * pattern on the attribute can match.
+ */
+static const char *view_get_criteria_value(struct sway_view *view,
+		enum criteria_attr attr) {
+	const char *value = view_get_criteria_attr(view, attr);
+	switch (attr) {
+	case CRITERIA_ATTR_SANDBOX_ENGINE:
+	case CRITERIA_ATTR_SANDBOX_APP_ID:
+	case CRITERIA_ATTR_SANDBOX_INSTANCE_ID:
+		return value;
+	default:
+		return value ? value : "";
+	}
+}
+
+/**
+ * Pick the literal pattern a criteria is indexed by. Exact literals are
+ * preferred, then the attributes least likely to be shared between views.
+ */
+static struct pattern *criteria_index_key(struct criteria *criteria,
+		enum criteria_attr *attr) {
+	static const enum criteria_attr order[] = {
+		CRITERIA_ATTR_APP_ID,
+#if WLR_HAS_XWAYLAND
+		CRITERIA_ATTR_CLASS,
+		CRITERIA_ATTR_INSTANCE,
+		CRITERIA_ATTR_WINDOW_ROLE,
+#endif
+		CRITERIA_ATTR_SANDBOX_APP_ID,
+		CRITERIA_ATTR_SANDBOX_INSTANCE_ID,
+		CRITERIA_ATTR_TITLE,
+		CRITERIA_ATTR_SANDBOX_ENGINE,
+		CRITERIA_ATTR_SHELL,
+	};
+	struct pattern *key = NULL;
+	for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); ++i) {
+		struct pattern *pattern = criteria_get_pattern(criteria, order[i]);
+		if (!pattern || !pattern->literal) {
+			continue;
+		}
+		if (!key || (pattern->literal_exact && !key->literal_exact)) {
+			key = pattern;
+			*attr = order[i];
+		}
+		if (key->literal_exact) {
+			break;
+		}
+	}
+	return key;
+}
+
+struct criteria_index_entry {
+	enum criteria_attr attr;
+	bool exact;
+	const char *literal;
+	size_t literal_len;
+	int *positions; // in config->criteria, ascending
+	int length, capacity;
+	struct criteria_index_entry *next;
+};
+
+/**
+ * Dispatch index over config->criteria. Criteria with a literal pattern are
+ * bucketed by attribute and literal, the rest are always candidates.
+ */
+static struct {
+	list_t *criteria;
+	uint32_t serial;
+	int length;
+	struct criteria_index_entry **buckets;
+	size_t nbuckets;
+	int *unindexed;
+	int unindexed_length;
+	bool has_exact[CRITERIA_ATTR_COUNT];
+	// Distinct prefix lengths of each attribute
+	size_t *prefix_lens[CRITERIA_ATTR_COUNT];
+	int prefix_lens_length[CRITERIA_ATTR_COUNT];
+} criteria_index;
+
+static size_t criteria_index_hash(enum criteria_attr attr, bool exact,
+		const char *literal, size_t len) {
+	uint32_t hash = 2166136261u ^ ((attr << 1) | exact);
+	for (size_t i = 0; i < len; ++i) {
+		hash = (hash ^ (unsigned char)literal[i]) * 16777619u;
+	}
+	return hash & (criteria_index.nbuckets - 1);
+}
+
+static struct criteria_index_entry *criteria_index_find(
+		enum criteria_attr attr, bool exact, const char *literal, size_t len) {
+	size_t bucket = criteria_index_hash(attr, exact, literal, len);
+	struct criteria_index_entry *entry = criteria_index.buckets[bucket];
+	for (; entry; entry = entry->next) {
+		if (entry->attr == attr && entry->exact == exact &&
+				entry->literal_len == len &&
+				memcmp(entry->literal, literal, len) == 0) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+static void criteria_index_finish(void) {
+	for (size_t i = 0; i < criteria_index.nbuckets; ++i) {
+		struct criteria_index_entry *entry = criteria_index.buckets[i];
+		while (entry) {
+			struct criteria_index_entry *next = entry->next;
+			free(entry->positions);
+			free(entry);
+			entry = next;
+		}
+	}
+	free(criteria_index.buckets);
+	free(criteria_index.unindexed);
+	for (int i = 0; i < CRITERIA_ATTR_COUNT; ++i) {
+		free(criteria_index.prefix_lens[i]);
+	}
+	memset(&criteria_index, 0, sizeof(criteria_index));
+}
+
+static bool int_array_add(int **items, int *length, int *capacity, int item) {
+	if (*length == *capacity) {
+		int new_capacity = *capacity ? *capacity * 2 : 4;
+		int *new_items = realloc(*items, new_capacity * sizeof(int));
+		if (!new_items) {
+			return false;
+		}
+		*items = new_items;
+		*capacity = new_capacity;
+	}
+	(*items)[(*length)++] = item;
+	return true;
+}
+
+static bool criteria_index_has_prefix_len(enum criteria_attr attr,
+		size_t len) {
+	for (int i = 0; i < criteria_index.prefix_lens_length[attr]; ++i) {
+		if (criteria_index.prefix_lens[attr][i] == len) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool criteria_index_add(int position, enum criteria_attr attr,
+		struct pattern *key) {
+	struct criteria_index_entry *entry = criteria_index_find(attr,
+			key->literal_exact, key->literal, key->literal_len);
+	if (!entry) {
+		entry = calloc(1, sizeof(*entry));
+		if (!entry) {
+			return false;
+		}
+		entry->attr = attr;
+		entry->exact = key->literal_exact;
+		entry->literal = key->literal;
+		entry->literal_len = key->literal_len;
+		size_t bucket = criteria_index_hash(attr, entry->exact,
+				entry->literal, entry->literal_len);
+		entry->next = criteria_index.buckets[bucket];
+		criteria_index.buckets[bucket] = entry;
+
+		if (entry->exact) {
+			criteria_index.has_exact[attr] = true;
+		} else if (!criteria_index_has_prefix_len(attr, entry->literal_len)) {
+			size_t *lens = realloc(criteria_index.prefix_lens[attr],
+					(criteria_index.prefix_lens_length[attr] + 1) *
+					sizeof(size_t));
+			if (!lens) {
+				return false;
+			}
+			lens[criteria_index.prefix_lens_length[attr]++] =
+				entry->literal_len;
+			criteria_index.prefix_lens[attr] = lens;
+		}
+	}
+	return int_array_add(&entry->positions, &entry->length,
+			&entry->capacity, position);
+}
+
+static bool criteria_index_rebuild(void) {
+	criteria_index_finish();
+	list_t *criterias = config->criteria;
+	criteria_index.nbuckets = 64;
+	while (criteria_index.nbuckets < (size_t)criterias->length) {
+		criteria_index.nbuckets *= 2;
+	}
+	criteria_index.buckets = calloc(criteria_index.nbuckets,
+			sizeof(*criteria_index.buckets));
+	criteria_index.unindexed = calloc(criterias->length + 1, sizeof(int));
+	if (!criteria_index.buckets || !criteria_index.unindexed) {
+		goto error;
+	}
+
+	for (int i = 0; i < criterias->length; ++i) {
+		enum criteria_attr attr = CRITERIA_ATTR_COUNT;
+		struct pattern *key = criteria_index_key(criterias->items[i], &attr);
+		if (!key) {
+			criteria_index.unindexed[criteria_index.unindexed_length++] = i;
+		} else if (!criteria_index_add(i, attr, key)) {
+			goto error;
+		}
+	}
+
+	criteria_index.criteria = criterias;
+	criteria_index.serial = criteria_serial;
+	criteria_index.length = criterias->length;
+	sway_log(SWAY_DEBUG, "Indexed %d of %d criteria by literal",
+			criterias->length - criteria_index.unindexed_length,
+			criterias->length);
+	return true;
+
+error:
+	sway_log(SWAY_ERROR, "Failed to allocate criteria index");
+	criteria_index_finish();
+	return false;
+}
+
+static void criteria_index_collect(struct criteria_index_entry *entry,
+		int *candidates, int *length) {
+	if (entry) {
+		memcpy(candidates + *length, entry->positions,
+				entry->length * sizeof(int));
+		*length += entry->length;
+	}
+}
+
+static int cmp_int(const void *_a, const void *_b) {
+	int a = *(const int *)_a;
+	int b = *(const int *)_b;
+	return (a > b) - (a < b);
+}
+
+/**
+ * Fill candidates, which must have room for all of config->criteria, with the
+ * ascending positions of the criteria which may match the view. Returns the
+ * number of candidates, or -1 if the index is unavailable.
+ */
+static int criteria_index_candidates(struct sway_view *view, int *candidates) {
+	if (criteria_index.criteria != config->criteria ||
+			criteria_index.serial != criteria_serial ||
+			criteria_index.length != config->criteria->length) {
+		if (!criteria_index_rebuild()) {
+			return -1;
+		}
+	}
+
+	int length = criteria_index.unindexed_length;
+	memcpy(candidates, criteria_index.unindexed, length * sizeof(int));
+	for (int attr = 0; attr < CRITERIA_ATTR_COUNT; ++attr) {
+		if (!criteria_index.has_exact[attr] &&
+				criteria_index.prefix_lens_length[attr] == 0) {
+			continue;
+		}
+		const char *value = view_get_criteria_value(view, attr);
+		if (!value) {
+			continue;
+		}
+		size_t value_len = strlen(value);
+		if (criteria_index.has_exact[attr]) {
+			criteria_index_collect(criteria_index_find(attr, true,
+					value, value_len), candidates, &length);
+			// $ also matches before a final newline
+			if (value_len > 0 && value[value_len - 1] == '\n') {
+				criteria_index_collect(criteria_index_find(attr, true,
+						value, value_len - 1), candidates, &length);
+			}
+		}
+		for (int i = 0; i < criteria_index.prefix_lens_length[attr]; ++i) {
+			size_t prefix_len = criteria_index.prefix_lens[attr][i];
+			if (prefix_len <= value_len) {
+				criteria_index_collect(criteria_index_find(attr, false,
+						value, prefix_len), candidates, &length);
+			}
+		}
+	}
+	qsort(candidates, length, sizeof(int), cmp_int);
+	return length;
+}
+
+/**
+ * Cheap rejection of views by the literal the criteria would be indexed by.
+ */
+static bool criteria_may_match_view(struct criteria *criteria,
+		struct sway_view *view) {
+	enum criteria_attr attr = CRITERIA_ATTR_COUNT;
+	struct pattern *key = criteria_index_key(criteria, &attr);
+	if (!key) {
+		return true;
+	}
+	const char *value = view_get_criteria_value(view, attr);
+	return value && pattern_literal_match(key, value);
 }
 
 #if WLR_HAS_XWAYLAND
@@ -188,8 +731,12 @@ static bool criteria_matches_container(struct criteria *criteria,
 	return true;
 }
 
+/**
+ * The cache is only used when it is not NULL, in which case index is the
+ * position of the criteria in config->criteria.
+ */
 static bool criteria_matches_view(struct criteria *criteria,
-		struct sway_view *view) {
+		struct sway_view *view, struct criteria_cache *cache, int index) {
 	struct sway_seat *seat = input_manager_current_seat();
 	struct sway_container *focus = seat_get_focused_container(seat);
 	struct sway_view *focused = focus ? focus->view : NULL;
@@ -207,7 +754,8 @@ static bool criteria_matches_view(struct criteria *criteria,
 			}
 			break;
 		case PATTERN_PCRE2:
-			if (regex_cmp(title, criteria->title->regex) < 0) {
+			if (!criteria_regex_match(cache, index, CRITERIA_ATTR_TITLE,
+					title, criteria->title)) {
 				return false;
 			}
 			break;
@@ -227,7 +775,8 @@ static bool criteria_matches_view(struct criteria *criteria,
 			}
 			break;
 		case PATTERN_PCRE2:
-			if (regex_cmp(shell, criteria->shell->regex) < 0) {
+			if (!criteria_regex_match(cache, index, CRITERIA_ATTR_SHELL,
+					shell, criteria->shell)) {
 				return false;
 			}
 			break;
@@ -247,7 +796,8 @@ static bool criteria_matches_view(struct criteria *criteria,
 			}
 			break;
 		case PATTERN_PCRE2:
-			if (regex_cmp(app_id, criteria->app_id->regex) < 0) {
+			if (!criteria_regex_match(cache, index, CRITERIA_ATTR_APP_ID,
+					app_id, criteria->app_id)) {
 				return false;
 			}
 			break;
@@ -267,7 +817,8 @@ static bool criteria_matches_view(struct criteria *criteria,
 			}
 			break;
 		case PATTERN_PCRE2:
-			if (regex_cmp(sandbox_engine, criteria->sandbox_engine->regex) < 0) {
+			if (!criteria_regex_match(cache, index, CRITERIA_ATTR_SANDBOX_ENGINE,
+					sandbox_engine, criteria->sandbox_engine)) {
 				return false;
 			}
 			break;
@@ -287,7 +838,8 @@ static bool criteria_matches_view(struct criteria *criteria,
 			}
 			break;
 		case PATTERN_PCRE2:
-			if (regex_cmp(sandbox_app_id, criteria->sandbox_app_id->regex) < 0) {
+			if (!criteria_regex_match(cache, index, CRITERIA_ATTR_SANDBOX_APP_ID,
+					sandbox_app_id, criteria->sandbox_app_id)) {
 				return false;
 			}
 			break;
@@ -307,7 +859,8 @@ static bool criteria_matches_view(struct criteria *criteria,
 			}
 			break;
 		case PATTERN_PCRE2:
-			if (regex_cmp(sandbox_instance_id, criteria->sandbox_instance_id->regex) < 0) {
+			if (!criteria_regex_match(cache, index, CRITERIA_ATTR_SANDBOX_INSTANCE_ID,
+					sandbox_instance_id, criteria->sandbox_instance_id)) {
 				return false;
 			}
 			break;
@@ -339,7 +892,8 @@ static bool criteria_matches_view(struct criteria *criteria,
 			}
 			break;
 		case PATTERN_PCRE2:
-			if (regex_cmp(class, criteria->class->regex) < 0) {
+			if (!criteria_regex_match(cache, index, CRITERIA_ATTR_CLASS,
+					class, criteria->class)) {
 				return false;
 			}
 			break;
@@ -359,7 +913,8 @@ static bool criteria_matches_view(struct criteria *criteria,
 			}
 			break;
 		case PATTERN_PCRE2:
-			if (regex_cmp(instance, criteria->instance->regex) < 0) {
+			if (!criteria_regex_match(cache, index, CRITERIA_ATTR_INSTANCE,
+					instance, criteria->instance)) {
 				return false;
 			}
 			break;
@@ -379,7 +934,8 @@ static bool criteria_matches_view(struct criteria *criteria,
 			}
 			break;
 		case PATTERN_PCRE2:
-			if (regex_cmp(window_role, criteria->window_role->regex) < 0) {
+			if (!criteria_regex_match(cache, index, CRITERIA_ATTR_WINDOW_ROLE,
+					window_role, criteria->window_role)) {
 				return false;
 			}
 			break;
@@ -457,12 +1013,24 @@ static bool criteria_matches_view(struct criteria *criteria,
 list_t *criteria_for_view(struct sway_view *view, enum criteria_type types) {
 	list_t *criterias = config->criteria;
 	list_t *matches = create_list();
-	for (int i = 0; i < criterias->length; ++i) {
+	struct criteria_cache *cache = criteria_cache_prepare(view);
+	int *candidates = malloc((criterias->length + 1) * sizeof(int));
+	int length = candidates ?
+		criteria_index_candidates(view, candidates) : -1;
+	if (length < 0) {
+		length = criterias->length;
+		free(candidates);
+		candidates = NULL;
+	}
+	for (int j = 0; j < length; ++j) {
+		int i = candidates ? candidates[j] : j;
 		struct criteria *criteria = criterias->items[i];
-		if ((criteria->type & types) && criteria_matches_view(criteria, view)) {
+		if ((criteria->type & types) &&
+				criteria_matches_view(criteria, view, cache, i)) {
 			list_add(matches, criteria);
 		}
 	}
+	free(candidates);
 	return matches;
 }
 
@@ -475,7 +1043,9 @@ static void criteria_get_containers_iterator(struct sway_container *container,
 		void *data) {
 	struct match_data *match_data = data;
 	if (container->view) {
-		if (criteria_matches_view(match_data->criteria, container->view)) {
+		if (criteria_may_match_view(match_data->criteria, container->view) &&
+				criteria_matches_view(match_data->criteria, container->view,
+					NULL, -1)) {
 			list_add(match_data->matches, container);
 		}
 	} else if (has_container_criteria(match_data->criteria)) {
@@ -1,5 +1,8 @@
 #include "sway/desktop/animation.h"
+#include "sway/output.h"
+#include "sway/perf.h"
 #include "sway/server.h"
+#include "sway/tree/root.h"
 #include "log.h"
 #include "util.h"
 #include <wayland-server-core.h>
@@ -27,6 +30,9 @@ struct sway_animation_curve {
 static struct sway_animation animation = {
 	.timer = NULL,
 	.step = 0,
+	.running = false,
+	.progress = 1.0,
+	.output = NULL,
 	.mode = ANIM_DEFAULT,
 };
 
@@ -107,9 +113,27 @@ static void create_lookup(struct bezier_curve *curve) {
 	free(T);
 }
 
+// Outputs step at their own presentation times, a step predicted before the
+// last recorded one is not counted
+static void animation_record_step(struct sway_animation *animation,
+		const struct timespec *now) {
+	struct timespec elapsed;
+	timespec_sub(&elapsed, now, &animation->last_step);
+	int64_t nsec = timespec_to_nsec(&elapsed);
+	if (nsec <= 0) {
+		return;
+	}
+	perf_record(PERF_ANIMATION_STEP, nsec);
+	animation->last_step = *now;
+}
+
 static int timer_callback(void *data) {
 	struct sway_animation *animation = data;
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	animation_record_step(animation, &now);
 	++animation->step;
+	animation->progress = animation->step / (double)animation->nsteps;
 	if (animation->step <= animation->nsteps) {
 		if (animation->callback_step) {
 			animation->callback_step(animation->data_step);
@@ -155,24 +179,57 @@ static uint32_t animation_get_duration_ms() {
 	}
 }
 
+static void animation_schedule_frames() {
+	for (int i = 0; i < root->outputs->length; ++i) {
+		struct sway_output *output = root->outputs->items[i];
+		if (output->enabled && output->wlr_output->enabled) {
+			wlr_output_schedule_frame(output->wlr_output);
+		}
+	}
+}
+
 // Set the callback for the current animation, and start animating
 void animation_start(sway_animation_callback_func_t callback_begin, void *data_begin,
 		sway_animation_callback_func_t callback, void *data,
 		sway_animation_callback_func_t callback_end, void *data_end) {
+	if (animation.timer) {
+		wl_event_source_remove(animation.timer);
+		animation.timer = NULL;
+	}
+	animation.running = false;
 	if (animation_enabled()) {
+		animation.callback_step = callback;
+		animation.data_step = data;
+		animation.callback_end = callback_end;
+		animation.data_end = data_end;
+		if (config->animations.frame_clock) {
+			clock_gettime(CLOCK_MONOTONIC, &animation.start);
+			animation.last_step = animation.start;
+			animation.duration_ms = max(1, animation_get_duration_ms());
+			animation.progress = 0.0;
+			for (int i = 0; i < root->outputs->length; ++i) {
+				struct sway_output *output = root->outputs->items[i];
+				output->animation_progress = 0.0;
+			}
+			if (callback_begin) {
+				callback_begin(data_begin);
+			}
+			callback(data);
+			// Steps are evaluated from now on by animation_frame(), make sure
+			// every output produces a frame even if the first one did not
+			// damage it.
+			animation.running = true;
+			animation_schedule_frames();
+			return;
+		}
 		animation.nsteps = max(1, animation_get_duration_ms() / config->animations.frequency_ms);
 		animation.step = 1;
+		animation.progress = animation.step / (double)animation.nsteps;
 		if (callback_begin) {
 			callback_begin(data_begin);
 		}
 		callback(data);
-		if (animation.timer) {
-			wl_event_source_remove(animation.timer);
-		}
-		animation.callback_step = callback;
-		animation.data_step = data;
-		animation.callback_end = callback_end;
-		animation.data_end = data_end;
+		clock_gettime(CLOCK_MONOTONIC, &animation.last_step);
 		animation.timer = wl_event_loop_add_timer(server.wl_event_loop,
 			timer_callback, &animation);
 		if (animation.timer) {
@@ -185,6 +242,52 @@ void animation_start(sway_animation_callback_func_t callback_begin, void *data_b
 	}
 }
 
+bool animation_frame_clock_running() {
+	return animation.running;
+}
+
+struct sway_output *animation_frame_output() {
+	return animation.output;
+}
+
+void animation_frame(struct sway_output *output, const struct timespec *when) {
+	if (!animation.running) {
+		return;
+	}
+	animation_record_step(&animation, when);
+	struct timespec elapsed;
+	timespec_sub(&elapsed, when, &animation.start);
+	double u = timespec_to_nsec(&elapsed) / (animation.duration_ms * 1000000.0);
+	if (u < 1.0) {
+		// Only this output's part of the scene is re-arranged, at its own
+		// point of the curve. The other outputs keep the step they sampled
+		// last until their next frame.
+		if (u <= output->animation_progress) {
+			return;
+		}
+		output->animation_progress = u;
+		animation.progress = u;
+		animation.output = output;
+		if (animation.callback_step) {
+			animation.callback_step(animation.data_step);
+		}
+		animation.output = NULL;
+		return;
+	}
+	// Last step: the first frame past the end finishes the animation on
+	// every output. The others are at most one refresh away from it, and
+	// get the final state with the damage this step produces.
+	animation.running = false;
+	animation.progress = 1.0;
+	if (animation.callback_step) {
+		animation.callback_step(animation.data_step);
+	}
+	animation.mode = ANIM_DEFAULT;
+	if (animation.callback_end) {
+		animation.callback_end(animation.data_end);
+	}
+}
+
 // Create a new animation. Call this before animation_start()
 void animation_create(enum sway_animation_mode mode) {
 	animation.mode = mode;
@@ -278,7 +381,7 @@ void animation_get_values(double *t, double *x, double *y, double *off_scale) {
 		*t = 1.0; *x = 1.0, *y = 0.0, *off_scale = 0.0;
 		return;
 	}
-	double u = animation.step / (double)animation.nsteps;
+	double u = animation.progress;
 	switch (animation.mode) {
 	case ANIM_DEFAULT:
 		animation_curve_get_values(config->animations.anim_default, u, t, x, y, off_scale);
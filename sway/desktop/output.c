@@ -21,13 +21,16 @@
 #include <wlr/util/transform.h>
 #include "config.h"
 #include "log.h"
+#include "util.h"
 #include "sway/config.h"
+#include "sway/desktop/animation.h"
 #include "sway/desktop/transaction.h"
 #include "sway/input/input-manager.h"
 #include "sway/input/seat.h"
 #include "sway/ipc-server.h"
 #include "sway/layers.h"
 #include "sway/output.h"
+#include "sway/perf.h"
 #include "sway/scene_descriptor.h"
 #include "sway/server.h"
 #include "sway/tree/arrange.h"
@@ -168,8 +171,10 @@ static void send_frame_done_iterator(struct sway_scene_buffer *buffer,
 		return;
 	}
 
-	struct sway_scene_node *current = &buffer->node;
-	while (true) {
+	// The view's max_render_time only matters if the output has one
+	struct sway_scene_node *current =
+		output->max_render_time != 0 ? &buffer->node : NULL;
+	while (current) {
 		struct sway_view *view = scene_descriptor_try_get(current,
 			SWAY_SCENE_DESC_VIEW);
 		if (view) {
@@ -219,6 +224,29 @@ static enum wlr_scale_filter_mode get_scale_filter(struct sway_output *output,
 	}
 }
 
+static void output_configure_buffer(struct sway_output *output,
+		struct sway_scene_buffer *buffer, float opacity) {
+	struct sway_scene_surface *surface = sway_scene_surface_try_from_buffer(buffer);
+
+	if (surface) {
+		const struct wlr_alpha_modifier_surface_v1_state *alpha_modifier_state =
+			wlr_alpha_modifier_v1_get_surface_state(surface->surface);
+		if (alpha_modifier_state != NULL) {
+			opacity *= (float)alpha_modifier_state->multiplier;
+		}
+	}
+
+	// hack: don't call the scene setter because that will damage all outputs
+	// We don't want to damage outputs that aren't our current output that
+	// we're configuring
+	if (output) {
+		buffer->filter_mode = get_scale_filter(output, buffer);
+	}
+
+	sway_scene_buffer_set_opacity(buffer, opacity);
+	buffer->opacity_configured = true;
+}
+
 void output_configure_scene(struct sway_output *output,
 		struct sway_scene_node *node, float opacity) {
 	if (!node->enabled) {
@@ -232,25 +260,7 @@ void output_configure_scene(struct sway_output *output,
 	}
 
 	if (node->type == SWAY_SCENE_NODE_BUFFER) {
-		struct sway_scene_buffer *buffer = sway_scene_buffer_from_node(node);
-		struct sway_scene_surface *surface = sway_scene_surface_try_from_buffer(buffer);
-
-		if (surface) {
-			const struct wlr_alpha_modifier_surface_v1_state *alpha_modifier_state =
-				wlr_alpha_modifier_v1_get_surface_state(surface->surface);
-			if (alpha_modifier_state != NULL) {
-				opacity *= (float)alpha_modifier_state->multiplier;
-			}
-		}
-
-		// hack: don't call the scene setter because that will damage all outputs
-		// We don't want to damage outputs that aren't our current output that
-		// we're configuring
-		if (output) {
-			buffer->filter_mode = get_scale_filter(output, buffer);
-		}
-
-		sway_scene_buffer_set_opacity(buffer, opacity);
+		output_configure_buffer(output, sway_scene_buffer_from_node(node), opacity);
 	} else if (node->type == SWAY_SCENE_NODE_TREE) {
 		struct sway_scene_tree *tree = sway_scene_tree_from_node(node);
 		struct sway_scene_node *node;
@@ -260,6 +270,32 @@ void output_configure_scene(struct sway_output *output,
 	}
 }
 
+static void output_configure_buffer_iterator(struct sway_scene_buffer *buffer,
+		int x, int y, void *user_data) {
+	struct sway_output *output = user_data;
+
+	// The container alpha only changes through output_configure_scene(), and
+	// the alpha modifier with a surface commit, which resets the opacity
+	if (buffer->opacity_configured) {
+		buffer->filter_mode = get_scale_filter(output, buffer);
+		return;
+	}
+
+	// Same as output_configure_scene(): the closest container sets the alpha
+	float opacity = 1.0f;
+	for (struct sway_scene_node *node = &buffer->node; node;
+			node = node->parent ? &node->parent->node : NULL) {
+		struct sway_container *con =
+			scene_descriptor_try_get(node, SWAY_SCENE_DESC_CONTAINER);
+		if (con) {
+			opacity = con->alpha;
+			break;
+		}
+	}
+
+	output_configure_buffer(output, buffer, opacity);
+}
+
 static bool output_can_tear(struct sway_output *output) {
 	struct sway_workspace *workspace = output->current.active_workspace;
 	if (!workspace) {
@@ -277,6 +313,29 @@ static bool output_can_tear(struct sway_output *output) {
 	return false;
 }
 
+// Predict when the frame being rendered now will be presented: the first
+// refresh after the last presentation that is not in the past. Outputs with
+// no presentation feedback yet fall back to the current time.
+static void output_predict_presentation(struct sway_output *output,
+		struct timespec *when) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (output->refresh_nsec == 0 || (output->last_presentation.tv_sec == 0 &&
+			output->last_presentation.tv_nsec == 0)) {
+		*when = now;
+		return;
+	}
+	int64_t now_nsec = timespec_to_nsec(&now);
+	int64_t predicted = timespec_to_nsec(&output->last_presentation) +
+		output->refresh_nsec;
+	if (predicted < now_nsec) {
+		// Skip the refresh cycles that went by without a presentation
+		predicted += ((now_nsec - predicted) / output->refresh_nsec + 1) *
+			output->refresh_nsec;
+	}
+	timespec_from_nsec(when, predicted);
+}
+
 static int output_repaint_timer_handler(void *data) {
 	struct sway_output *output = data;
 
@@ -285,21 +344,72 @@ static int output_repaint_timer_handler(void *data) {
 		return 0;
 	}
 
-	output_configure_scene(output, &root->root_scene->tree.node, 1.0f);
+	struct timespec cpu_start;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_start);
+
+	struct timespec when;
+	output_predict_presentation(output, &when);
+	bool animating = animation_frame_clock_running();
+	if (animating) {
+		animation_frame(output, &when);
+		animating = animation_frame_clock_running();
+	}
+	// Gesture scrolling is applied once per frame, and glides on after the
+	// gesture ends when kinetic scrolling is enabled
+	if (layout_scroll_frame(output, &when)) {
+		animating = true;
+	}
+
+	// Only the buffers that can show up on this output need their opacity
+	// and filter mode updated, the rest is configured when it gets there.
+	// Unless the scene changed, those are the ones rendered last frame.
+	if (!sway_scene_output_for_each_rendered_buffer(output->scene_output,
+			output_configure_buffer_iterator, output)) {
+		sway_scene_output_for_each_buffer(output->scene_output,
+			output_configure_buffer_iterator, output);
+	}
 
+	struct sway_output_perf *stats = &output->perf;
 	struct sway_scene_output_state_options opts = {
 		.color_transform = output->color_transform,
+		.timer = &stats->timer,
 	};
 
 	struct sway_scene_output *scene_output = output->scene_output;
 	if (!sway_scene_output_needs_frame(scene_output)) {
+		if (animating) {
+			// Nothing moved on this output during this step, so no page-flip
+			// will bring the next frame event. Keep sampling the animation
+			// once per refresh until it ends.
+			int refresh_msec = output->refresh_nsec > 0 ?
+				(int)(output->refresh_nsec / 1000000) :
+				(int)config->animations.frequency_ms;
+			wl_event_source_timer_update(output->repaint_timer,
+				max(1, refresh_msec));
+		}
 		return 0;
 	}
 
+	// The previous frame has been presented by now, so its render timer
+	// can be read without stalling
+	if (stats->timer_pending) {
+		int64_t duration = sway_scene_timer_get_duration_ns(&stats->timer);
+		if (duration >= 0) {
+			perf_histogram_add(&stats->render, duration);
+		}
+		stats->timer_pending = false;
+	}
+
 	struct wlr_output_state pending;
 	wlr_output_state_init(&pending);
 
+	struct timespec build_start, build_end, build_time;
+	clock_gettime(CLOCK_MONOTONIC, &build_start);
 	bool ret = render_workspace_build_state(output, &pending, &opts);
+	clock_gettime(CLOCK_MONOTONIC, &build_end);
+	timespec_sub(&build_time, &build_end, &build_start);
+	perf_histogram_add(&stats->build_state, timespec_to_nsec(&build_time));
+	stats->timer_pending = ret;
 	if (!ret) {
 		wlr_output_state_finish(&pending);
 		return 0;
@@ -315,10 +425,16 @@ static int output_repaint_timer_handler(void *data) {
 		}
 	}
 
-	if (!wlr_output_commit_state(output->wlr_output, &pending)) {
+	if (wlr_output_commit_state(output->wlr_output, &pending)) {
+		stats->frames++;
+		stats->frame_pending = true;
+		stats->commit_time = build_end;
+		stats->predicted = when;
+	} else {
 		sway_log(SWAY_ERROR, "Page-flip failed on output %s", output->wlr_output->name);
 	}
 	wlr_output_state_finish(&pending);
+	perf_record_since(PERF_FRAME_CPU, CLOCK_THREAD_CPUTIME_ID, &cpu_start);
 	return 0;
 }
 
@@ -453,6 +569,11 @@ static void begin_destroy(struct sway_output *output) {
 	sway_scene_output_destroy(output->scene_output);
 	output->scene_output = NULL;
 
+	// The render timer belongs to the output renderer
+	sway_scene_timer_finish(&output->perf.timer);
+	output->perf.timer = (struct sway_scene_timer){0};
+	output->perf.timer_pending = false;
+
 	if (output->enabled) {
 		output_disable(output);
 	}
@@ -488,6 +609,21 @@ static void handle_present(struct wl_listener *listener, void *data) {
 
 	output->last_presentation = output_event->when;
 	output->refresh_nsec = output_event->refresh;
+
+	struct sway_output_perf *stats = &output->perf;
+	if (stats->frame_pending) {
+		stats->frame_pending = false;
+		struct timespec latency, late;
+		timespec_sub(&latency, &output_event->when, &stats->commit_time);
+		perf_histogram_add(&stats->present_latency, timespec_to_nsec(&latency));
+		// Count the refresh cycles the frame missed from its predicted one
+		timespec_sub(&late, &output_event->when, &stats->predicted);
+		int64_t late_nsec = timespec_to_nsec(&late);
+		if (output->refresh_nsec > 0 && late_nsec > output->refresh_nsec / 2) {
+			stats->missed_vblanks += (late_nsec + output->refresh_nsec / 2) /
+				output->refresh_nsec;
+		}
+	}
 }
 
 static void handle_request_state(struct wl_listener *listener, void *data) {
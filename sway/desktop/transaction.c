@@ -10,7 +10,9 @@
 #include "sway/desktop/animation.h"
 #include "sway/input/cursor.h"
 #include "sway/input/input-manager.h"
+#include "sway/ipc-server.h"
 #include "sway/output.h"
+#include "sway/perf.h"
 #include "sway/server.h"
 #include "sway/tree/container.h"
 #include "sway/tree/node.h"
@@ -27,6 +29,21 @@ struct sway_transaction {
 	size_t num_waiting;
 	size_t num_configures;
 	struct timespec commit_time;
+	// Workspaces touched by the transaction. Only those can move during the
+	// animation that follows it.
+	list_t *animated;    // struct sway_workspace *
+	bool animate_all;
+};
+
+// Subtrees re-arranged by each animation step of the last applied transaction
+static struct {
+	bool full;         // next step re-arranges the whole tree
+	bool all;          // every step re-arranges the whole tree
+	list_t *workspaces; // struct sway_workspace *
+} animation_arrange = {
+	.full = true,
+	.all = true,
+	.workspaces = NULL,
 };
 
 struct sway_transaction_instruction {
@@ -49,6 +66,7 @@ static struct sway_transaction *transaction_create(void) {
 		return NULL;
 	}
 	transaction->instructions = create_list();
+	transaction->animated = create_list();
 	return transaction;
 }
 
@@ -81,6 +99,7 @@ static void transaction_destroy(struct sway_transaction *transaction) {
 		free(instruction);
 	}
 	list_free(transaction->instructions);
+	list_free(transaction->animated);
 
 	if (transaction->timer) {
 		wl_event_source_remove(transaction->timer);
@@ -433,161 +452,99 @@ static double get_active_position_pin(struct sway_workspace *workspace,
 	}
 }
 
+struct active_position_search {
+	double beg, end; // viewport edges, with a pixel of slack for rounding
+	double origin, size;
+	double active; // current position of the active container
+	double sg; // scaled inner gap
+	const double *sums;
+	int active_idx, length;
+	double best_movement;
+};
+
+// Set the active at the left/top edge and test how many after it fit within
+// the viewport fully. For those that fit, locate each one at the end of the
+// viewport, and check the previous ones don't leave any empty space.
+static void search_active_at_beginning(struct active_position_search *s) {
+	const double *p = s->sums;
+	const int a = s->active_idx;
+	const double right = s->origin + s->size;
+	for (int c = a; c < s->length; ++c) {
+		double fit = s->origin + s->sg + (p[c + 1] - p[a]) - (c - a + 1) * s->sg;
+		if (fit > s->end) {
+			break;
+		}
+		// Walking back from c, the active is only reached if no container
+		// after it falls out of the viewport, and there is no empty space if
+		// the first one does.
+		bool reaches = c == a || right - (p[c + 1] - p[a + 1]) >= s->beg;
+		bool filled = right - p[c + 1] <= s->beg;
+		double movement = right - (p[c + 1] - p[a]) + s->sg - s->active;
+		if (reaches && filled && fabs(movement) < fabs(s->best_movement)) {
+			s->best_movement = movement;
+		}
+	}
+}
+
+// Set the active at the right/bottom edge and test how many before it fit
+// within the viewport fully. For those that fit, locate each one at the
+// beginning of the viewport, and check the next ones don't leave any empty
+// space.
+static void search_active_at_end(struct active_position_search *s) {
+	const double *p = s->sums;
+	const int a = s->active_idx;
+	const double right = s->origin + s->size;
+	for (int c = a; c >= 0; --c) {
+		double fit = right - s->sg - (p[a + 1] - p[c]) + (a - c + 1) * s->sg;
+		if (fit < s->beg) {
+			break;
+		}
+		bool reaches = c == a || s->origin + (p[a] - p[c]) <= s->end;
+		bool filled = s->origin + (p[s->length] - p[c]) >= s->end;
+		double movement = s->origin + (p[a] - p[c]) + s->sg - s->active;
+		if (reaches && filled && fabs(movement) < fabs(s->best_movement)) {
+			s->best_movement = movement;
+		}
+	}
+}
+
 static double get_active_position(struct sway_workspace *workspace,
 		enum sway_container_layout layout, list_t *children, int active_idx,
-		int gaps, float scale) {
+		int gaps, float scale, const double *extents) {
 	// We consider all the possible positions where each container is at the
 	// left/top edge and at the right/bottom edge. We choose the one that leaves
 	// the active container inside the viewport, moves the active as little as
 	// possible, and leaves no empty space in the viewport.
-
-	// First, find the range of containers that being on each edge of the viewport,
-	// allow the active one to be seen completely.
-	double best_movement = DBL_MAX;
-	int c_l = 0, c_r = children->length - 1;
 	struct sway_container *active = children->items[active_idx];
+	struct active_position_search s = {
+		.sg = scale * gaps,
+		.sums = extents,
+		.active_idx = active_idx,
+		.length = children->length,
+		.best_movement = DBL_MAX,
+	};
 	if (layout == L_HORIZ) {
-		// Add/substract 1 to account for rounding errors due to widths/heights
-		// computed using layout fractions. The extra pixel will be absorbed by
-		// the gaps.
-		const double workspace_beg = workspace->x - 1;
-		const double workspace_end = workspace->x + workspace->width + 1;
-		const double a_x = active->pending.x;
-		// Set the active at the left/top edge and test how many after it
-		// fit within the viewport fully
-		double x1 = workspace->x + scale * gaps;
-		for (int c = active_idx; c < children->length; ++c) {
-			struct sway_container *con = children->items[c];
-			x1 += scale * (con->current.width + gaps);
-			// For those that fit, locate each one at the end of the viewport,
-			// and check the previous ones don't leave any empty space.
-			if (x1 <= workspace_end) {
-				c_r = c;
-				// Test from c_r to the beginning
-				double movement = DBL_MAX;
-				double cx0 = workspace->x + workspace->width;
-				bool space = true;
-				for (int i = c_r; i >= 0; i--) {
-					struct sway_container *con = children->items[i];
-					cx0 -= scale * (con->current.width + 2.0 * gaps);
-					if (i == active_idx) {
-						movement = (cx0 + scale * gaps) - a_x;
-					}
-					if (cx0 <= workspace_beg) {
-						space = false;
-						if (cx0 < workspace_beg) {
-							break;
-						}
-					}
-				}
-				if (!space && fabs(movement) < fabs(best_movement)) {
-					best_movement = movement;
-				}
-			} else {
-				break;
-			}
-		}
-		// Set the active at the right/bottom edge and test how many before it
-		// fit within the viewport fully
-		double x0 = workspace->x + workspace->width - scale * gaps;
-		for (int c = active_idx; c >= 0; --c) {
-			struct sway_container *con = children->items[c];
-			x0 -= scale * (con->current.width + gaps);
-			// For those that fit, locate each one at the beginning of the viewport,
-			// and check the next ones don't leave any empty space.
-			if (x0 >= workspace_beg) {
-				c_l = c;
-				// Test from c_l to the end
-				double movement = DBL_MAX;
-				double cx1 = workspace->x;
-				bool space = true;
-				for (int i = c_l; i < children->length; ++i) {
-					if (i == active_idx) {
-						movement = (cx1 + scale * gaps) - a_x;
-					}
-					struct sway_container *con = children->items[i];
-					cx1 += scale * (con->current.width + 2.0 * gaps);
-					if (cx1 >= workspace_end) {
-						space = false;
-						if (cx1 > workspace_end) {
-							break;
-						}
-					}
-				}
-				if (!space && fabs(movement) < fabs(best_movement)) {
-					best_movement = movement;
-				}
-			} else {
-				break;
-			}
-		}
-		return a_x + best_movement;
+		s.origin = workspace->x;
+		s.size = workspace->width;
+		s.active = active->pending.x;
 	} else {
-		const double workspace_beg = workspace->y - 1;
-		const double workspace_end = workspace->y + workspace->height + 1;
-		const double a_y = active->pending.y;
-		double y0 = workspace->y + workspace->height - scale * gaps;
-		for (int c = active_idx; c >= 0; --c) {
-			struct sway_container *con = children->items[c];
-			y0 -= scale * (con->current.height + gaps);
-			if (y0 >= workspace_beg) {
-				c_l = c;
-				// Test from c_l to the end
-				double movement = DBL_MAX;
-				double cy1 = workspace->y;
-				bool space = true;
-				for (int i = c_l; i < children->length; ++i) {
-					if (i == active_idx) {
-						movement = (cy1 + scale * gaps) - a_y;
-					}
-					struct sway_container *con = children->items[i];
-					cy1 += scale * (con->current.height + 2.0 * gaps);
-					if (cy1 >= workspace_end) {
-						space = false;
-						if (cy1 > workspace_end) {
-							break;
-						}
-					}
-				}
-				if (!space && fabs(movement) < fabs(best_movement)) {
-					best_movement = movement;
-				}
-			} else {
-				break;
-			}
-		}
-		double y1 = workspace->y + scale * gaps;
-		for (int c = active_idx; c < children->length; ++c) {
-			struct sway_container *con = children->items[c];
-			y1 += scale * (con->current.height + gaps);
-			if (y1 <= workspace_end) {
-				c_r = c;
-				// Test from c_r to the beginning
-				double movement = DBL_MAX;
-				double cy0 = workspace->y + workspace->height;
-				bool space = true;
-				for (int i = c_r; i >= 0; i--) {
-					struct sway_container *con = children->items[i];
-					cy0 -= scale * (con->current.height + 2.0 * gaps);
-					if (i == active_idx) {
-						movement = (cy0 + scale * gaps) - a_y;
-					}
-					if (cy0 <= workspace_beg) {
-						space = false;
-						if (cy0 < workspace_beg) {
-							break;
-						}
-					}
-				}
-				if (!space && fabs(movement) < fabs(best_movement)) {
-					best_movement = movement;
-				}
-			} else {
-				break;
-			}
-		}
-		return a_y + best_movement;
+		s.origin = workspace->y;
+		s.size = workspace->height;
+		s.active = active->pending.y;
+	}
+	// Add/substract 1 to account for rounding errors due to widths/heights
+	// computed using layout fractions. The extra pixel will be absorbed by
+	// the gaps.
+	s.beg = s.origin - 1;
+	s.end = s.origin + s.size + 1;
+	if (layout == L_HORIZ) {
+		search_active_at_beginning(&s);
+		search_active_at_end(&s);
+	} else {
+		search_active_at_end(&s);
+		search_active_at_beginning(&s);
 	}
+	return s.active + s.best_movement;
 }
 
 // Workspace stores in x, y the logical coordinate that will be applied to a node
@@ -609,51 +566,173 @@ static double compute_active_offset(struct sway_workspace *workspace,
 		if (center) {
 			return workspace->x + 0.5 * (width - scale * active->current.width);
 		}
-		// Center row if space available
-        double lwidth = 0, rwidth = 0;
-        for (int i = 0; i < active_idx; ++i) {
-			struct sway_container *con = children->items[i];
-            lwidth += scale * (con->current.width + 2 * gaps);
-        }
-		lwidth = round(lwidth);
-        for (int i = active_idx; i < children->length; ++i) {
-			struct sway_container *con = children->items[i];
-            rwidth += scale * (con->current.width + 2 * gaps);
-        }
-		rwidth = round(rwidth);
-        double twidth = lwidth + rwidth;
-        if (twidth <= width + 1) {
-            double start = 0.5 * (width - twidth);
-            return workspace->x + start + lwidth + scale * gaps;
-        }
 	} else {
 		bool center = layout_modifiers_get_center_vertical(workspace);
 		if (center) {
 			return workspace->y + 0.5 * (height - scale * active->pending.height);
 		}
-		// Center row if space available
-        double lheight = 0, rheight = 0;
-        for (int i = 0; i < active_idx; ++i) {
-			struct sway_container *con = children->items[i];
-            lheight += scale * (con->current.height + 2 * gaps);
-        }
-		lheight = round(lheight);
-        for (int i = active_idx; i < children->length; ++i) {
-			struct sway_container *con = children->items[i];
-            rheight += scale * (con->current.height + 2 * gaps);
-        }
-		rheight = round(rheight);
-        double theight = lheight + rheight;
-        if (theight <= height + 1) {
-            double start = 0.5 * (height - theight);
-            return workspace->y + start + lheight + scale * gaps;
-        }
-	}
-	if (pin) {
-		return get_active_position_pin(workspace, layout, children, active_idx, gaps, scale, pin);
+	}
+
+	const double *extents = layout_row_extents(layout, children, gaps, scale, true);
+	if (!extents) {
+		return layout == L_HORIZ ? active->pending.x : active->pending.y;
+	}
+	// Center row if space available
+	double before = round(extents[active_idx]);
+	double after = round(extents[children->length] - extents[active_idx]);
+	double total = before + after;
+	double available = layout == L_HORIZ ? width : height;
+	double position;
+	if (total <= available + 1) {
+		double start = 0.5 * (available - total);
+		double origin = layout == L_HORIZ ? workspace->x : workspace->y;
+		position = origin + start + before + scale * gaps;
+	} else if (pin) {
+		position = get_active_position_pin(workspace, layout, children,
+			active_idx, gaps, scale, pin);
 	} else {
-		return get_active_position(workspace, layout, children, active_idx, gaps, scale);
+		position = get_active_position(workspace, layout, children, active_idx,
+			gaps, scale, extents);
 	}
+	return position;
+}
+
+// With layout_offscreen_margin set, children of a row that are farther than
+// the margin from the visible workspace area are not arranged. The scene
+// subtree is disabled, so their surfaces leave the output and stop receiving
+// frame events until they come back into view.
+static bool arrange_child_offscreen(struct sway_workspace *workspace,
+		enum sway_container_layout layout, struct sway_container *child,
+		float scale) {
+	int margin = config->layout_offscreen_margin;
+	if (margin < 0 || layout_overview_workspaces_enabled()) {
+		return false;
+	}
+	struct sway_container *parent = child->pending.parent;
+	if (parent && parent->jump.jumping) {
+		return false;
+	}
+	double beg, end, view_beg, view_end;
+	if (layout == L_HORIZ) {
+		beg = child->animation.xt;
+		end = beg + scale * child->animation.wt;
+		view_beg = workspace->x - margin;
+		view_end = workspace->x + workspace->width + margin;
+	} else {
+		beg = child->animation.yt;
+		end = beg + scale * child->animation.ht;
+		view_beg = workspace->y - margin;
+		view_end = workspace->y + workspace->height + margin;
+	}
+	return end < view_beg || beg > view_end;
+}
+
+static void set_child_position(enum sway_container_layout layout,
+		struct sway_workspace *workspace, struct sway_container *child,
+		double off, float scale, int gaps) {
+	struct sway_container *parent = child->pending.parent;
+	if (layout == L_HORIZ) {
+		child->current.x = off;
+		child->pending.x = off;
+		if (parent) {
+			child->current.y = parent->current.y;
+			child->pending.y = parent->pending.y;
+		} else {
+			child->current.y = workspace->y + scale * gaps;
+			child->pending.y = workspace->y + scale * gaps;
+		}
+	} else {
+		child->current.y = off;
+		child->pending.y = off;
+		if (parent) {
+			child->current.x = parent->current.x;
+			child->pending.x = parent->pending.x;
+		} else {
+			child->current.x = workspace->x + scale * gaps;
+			child->pending.x = workspace->x + scale * gaps;
+		}
+	}
+}
+
+static void arrange_positions(struct sway_container *con, int gaps);
+
+// The layout part of arrange_children() for the subtree of an off-screen
+// child: logical positions and content geometry are kept up to date for
+// transactions and IPC, but the scene, borders, clips and configures are left
+// alone until the child comes back into view.
+static void arrange_children_positions(enum sway_container_layout layout,
+		list_t *children, struct sway_container *active, int gaps) {
+	if (children->length == 0) {
+		return;
+	}
+	int active_idx = list_find(children, active);
+	if (active_idx == -1) {
+		active_idx = 0;
+		active = children->items[active_idx];
+	}
+	struct sway_workspace *workspace = active->pending.workspace;
+	float scale = layout_scale_enabled(workspace) ? layout_scale_get(workspace) : 1.0f;
+
+	struct sway_container *pin = layout_pin_enabled(workspace) &&
+		layout == layout_get_type(workspace) ?
+		layout_pin_get_container(workspace) : NULL;
+
+	double offset;
+	if (workspace->gesture.scrolling || layout_modifiers_get_reorder(workspace) == REORDER_LAZY) {
+		offset = layout == L_HORIZ ? active->pending.x : active->pending.y;
+	} else {
+		offset = compute_active_offset(workspace, layout, children, active_idx,
+			workspace->width, workspace->height, gaps, pin);
+		if (pin) {
+			active_idx = max(list_find(children, active), 0);
+		}
+	}
+
+	double off = offset;
+	for (int i = active_idx; i < children->length; ++i) {
+		struct sway_container *child = children->items[i];
+		struct sway_container *parent = child->pending.parent;
+		if (parent && parent->jump.jumping) {
+			off = layout == L_HORIZ ? child->pending.x : child->pending.y;
+		}
+		set_child_position(layout, workspace, child, off, scale, gaps);
+		arrange_positions(child, gaps);
+		off += scale * ((layout == L_HORIZ ? child->pending.width :
+			child->pending.height) + 2 * gaps);
+	}
+	off = offset;
+	for (int i = active_idx - 1; i >= 0; i--) {
+		struct sway_container *child = children->items[i];
+		struct sway_container *parent = child->pending.parent;
+		off -= scale * ((layout == L_HORIZ ? child->pending.width :
+			child->pending.height) + 2 * gaps);
+		if (parent && parent->jump.jumping) {
+			off = layout == L_HORIZ ? child->pending.x : child->pending.y;
+		}
+		set_child_position(layout, workspace, child, off, scale, gaps);
+		arrange_positions(child, gaps);
+	}
+}
+
+static void arrange_positions(struct sway_container *con, int gaps) {
+	if (con->view) {
+		view_autoconfigure(con->view);
+	} else {
+		arrange_children_positions(con->current.layout, con->current.children,
+			con->current.focused_inactive_child, gaps);
+	}
+}
+
+static void arrange_child(struct sway_workspace *workspace,
+		enum sway_container_layout layout, struct sway_container *child,
+		float scale, int gaps) {
+	if (arrange_child_offscreen(workspace, layout, child, scale)) {
+		child->offscreen = true;
+		sway_scene_node_set_enabled(&child->scene_tree->node, false);
+		arrange_positions(child, gaps);
+		return;
+	}
+	arrange_container(child, child->animation.wt, child->animation.ht, true, gaps);
 }
 
 static void arrange_children(enum sway_container_layout layout, list_t *children,
@@ -727,7 +806,7 @@ static void arrange_children(enum sway_container_layout layout, list_t *children
 			}
 			sway_scene_node_reparent(&child->scene_tree->node, content);
 			child->animation.wt = max(1, linear_scale(child->animation.w0, child->animation.w1, t));
-			arrange_container(child, child->animation.wt, child->animation.ht, true, gaps);
+			arrange_child(workspace, layout, child, scale, gaps);
 			off += scale * (child->pending.height + 2 * gaps);
 		}
 		off = offset;
@@ -760,7 +839,7 @@ static void arrange_children(enum sway_container_layout layout, list_t *children
 			sway_scene_node_set_position(&child->scene_tree->node, 0, round(child->animation.yt - workspace->y));
 			sway_scene_node_reparent(&child->scene_tree->node, content);
 			child->animation.wt = max(1, linear_scale(child->animation.w0, child->animation.w1, t));
-			arrange_container(child, child->animation.wt, child->animation.ht, true, gaps);
+			arrange_child(workspace, layout, child, scale, gaps);
 		}
 	} else if (layout == L_HORIZ) {
 		double off = offset;
@@ -796,7 +875,7 @@ static void arrange_children(enum sway_container_layout layout, list_t *children
 			}
 			sway_scene_node_reparent(&child->scene_tree->node, content);
 			child->animation.ht = max(1, linear_scale(child->animation.h0, child->animation.h1, t));
-			arrange_container(child, child->animation.wt, child->animation.ht, true, gaps);
+			arrange_child(workspace, layout, child, scale, gaps);
 			off += scale * (child->pending.width + 2 * gaps);
 		}
 		off = offset;
@@ -829,7 +908,7 @@ static void arrange_children(enum sway_container_layout layout, list_t *children
 			sway_scene_node_set_position(&child->scene_tree->node, round(child->animation.xt - workspace->x), 0);
 			sway_scene_node_reparent(&child->scene_tree->node, content);
 			child->animation.ht = max(1, linear_scale(child->animation.h0, child->animation.h1, t));
-			arrange_container(child, child->animation.wt, child->animation.ht, true, gaps);
+			arrange_child(workspace, layout, child, scale, gaps);
 		}
 	} else {
 		sway_assert(false, "unreachable");
@@ -873,6 +952,7 @@ static void arrange_container(struct sway_container *con,
 	// this container might have previously been in the scratchpad,
 	// make sure it's enabled for viewing
 	sway_scene_node_set_enabled(&con->scene_tree->node, true);
+	con->offscreen = false;
 
 	if (con->output_handler) {
 		sway_scene_buffer_set_dest_size(con->output_handler, round(dwidth), round(dheight));
@@ -997,6 +1077,7 @@ static void arrange_fullscreen(struct sway_scene_tree *tree,
 
 		// if we only care about the view, disable any decorations
 		sway_scene_node_set_enabled(&fs->scene_tree->node, false);
+		fs->offscreen = false;
 	} else {
 		fs_node = &fs->scene_tree->node;
 		arrange_container(fs, width, height, true, container_get_gaps(fs));
@@ -1235,8 +1316,84 @@ static void arrange_root(struct sway_root *root) {
 /**
  * Apply a transaction to the "current" state of the tree.
  */
+static bool node_list_changed(list_t *current, list_t *state) {
+	int length = current ? current->length : 0;
+	if (length != (state ? state->length : 0)) {
+		return true;
+	}
+	for (int i = 0; i < length; ++i) {
+		if (current->items[i] != state->items[i]) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Compares the state of an instruction with the node's current one, for the
+// IPC tree event
+static uint32_t instruction_tree_changes(struct sway_transaction_instruction *instruction) {
+	struct sway_node *node = instruction->node;
+	if (node->destroying) {
+		return node->applied ? IPC_TREE_CLOSE : 0;
+	}
+	if (!node->applied) {
+		return node->type == N_ROOT ? 0 : IPC_TREE_NEW;
+	}
+
+	uint32_t changes = 0;
+	switch (node->type) {
+	case N_ROOT:
+		break;
+	case N_OUTPUT:;
+		struct sway_output_state *output_state = &instruction->output_state;
+		if (node_list_changed(node->sway_output->current.workspaces,
+				output_state->workspaces)) {
+			changes |= IPC_TREE_CHILDREN;
+		}
+		break;
+	case N_WORKSPACE:;
+		struct sway_workspace_state *ws_current = &node->sway_workspace->current;
+		struct sway_workspace_state *ws_state = &instruction->workspace_state;
+		if (ws_current->x != ws_state->x || ws_current->y != ws_state->y ||
+				ws_current->width != ws_state->width ||
+				ws_current->height != ws_state->height) {
+			changes |= IPC_TREE_GEOMETRY;
+		}
+		if (ws_current->focused != ws_state->focused) {
+			changes |= IPC_TREE_FOCUS;
+		}
+		if (node_list_changed(ws_current->tiling, ws_state->tiling) ||
+				node_list_changed(ws_current->floating, ws_state->floating)) {
+			changes |= IPC_TREE_CHILDREN;
+		}
+		break;
+	case N_CONTAINER:;
+		struct sway_container_state *current = &node->sway_container->current;
+		struct sway_container_state *state = &instruction->container_state;
+		if (current->parent != state->parent ||
+				current->workspace != state->workspace) {
+			changes |= IPC_TREE_MOVE;
+		}
+		if (current->x != state->x || current->y != state->y ||
+				current->width != state->width ||
+				current->height != state->height) {
+			changes |= IPC_TREE_GEOMETRY;
+		}
+		if (current->focused != state->focused) {
+			changes |= IPC_TREE_FOCUS;
+		}
+		if (node_list_changed(current->children, state->children)) {
+			changes |= IPC_TREE_CHILDREN;
+		}
+		break;
+	}
+	return changes;
+}
+
 static void transaction_apply(struct sway_transaction *transaction) {
 	sway_log(SWAY_DEBUG, "Applying transaction %p", transaction);
+	perf_record_since(PERF_TXN_LATENCY, CLOCK_MONOTONIC,
+		&transaction->commit_time);
 	if (debug.txn_timings) {
 		struct timespec now;
 		clock_gettime(CLOCK_MONOTONIC, &now);
@@ -1248,10 +1405,13 @@ static void transaction_apply(struct sway_transaction *transaction) {
 	}
 
 	// Apply the instruction state to the node's current state
+	bool tree_event = ipc_event_tree_has_listeners();
 	for (int i = 0; i < transaction->instructions->length; ++i) {
 		struct sway_transaction_instruction *instruction =
 			transaction->instructions->items[i];
 		struct sway_node *node = instruction->node;
+		uint32_t tree_changes = tree_event ?
+			instruction_tree_changes(instruction) : 0;
 
 		switch (node->type) {
 		case N_ROOT:
@@ -1270,11 +1430,103 @@ static void transaction_apply(struct sway_transaction *transaction) {
 		}
 
 		node->instruction = NULL;
+		node->applied = true;
+		if (tree_changes) {
+			ipc_event_tree_add(node, tree_changes);
+		}
+	}
+
+	if (tree_event) {
+		ipc_event_tree_send();
+	}
+}
+
+static struct sway_output *workspace_get_current_output(struct sway_workspace *ws) {
+	for (int i = 0; i < root->outputs->length; ++i) {
+		struct sway_output *output = root->outputs->items[i];
+		if (list_find(output->current.workspaces, ws) != -1) {
+			return output;
+		}
+	}
+	return NULL;
+}
+
+// Animation step for a single workspace. This is the part of arrange_output()
+// that depends on the animation parameters; scene reparenting and enabling
+// have already been done by the full arrange at the start of the animation.
+// If only is not NULL, workspaces on other outputs are left alone.
+static void arrange_workspace_animation_step(struct sway_workspace *ws,
+		struct sway_output *only) {
+	if (ws->node.destroying) {
+		return;
+	}
+	struct sway_output *output = workspace_get_current_output(ws);
+	if (!output || !output->wlr_output->enabled) {
+		return;
+	}
+	if (only && output != only) {
+		return;
+	}
+	if (!layout_overview_workspaces_enabled() &&
+			output->current.active_workspace != ws) {
+		return;
+	}
+
+	struct sway_container *fs = ws->current.fullscreen;
+	if (fs) {
+		if (!fs->view) {
+			arrange_container(fs, output->width, output->height, true,
+				container_get_gaps(fs));
+		}
+	} else {
+		struct wlr_box *area = &output->usable_area;
+		struct side_gaps *gaps = &ws->current_gaps;
+		arrange_workspace_tiling(ws,
+			area->width - gaps->left - gaps->right,
+			area->height - gaps->top - gaps->bottom);
 	}
+	arrange_workspace_floating(ws);
 }
 
 static void animation_callback(void *data) {
-	arrange_root(root);
+	// Frame clock steps are evaluated for one output at a time
+	struct sway_output *output = animation_frame_output();
+	if (animation_arrange.full || root->fullscreen_global) {
+		animation_arrange.full = false;
+		arrange_root(root);
+		return;
+	}
+	if (animation_arrange.all) {
+		if (!output) {
+			arrange_root(root);
+			return;
+		}
+		arrange_output(output, output->width, output->height);
+	} else {
+		for (int i = 0; i < animation_arrange.workspaces->length; ++i) {
+			arrange_workspace_animation_step(
+				animation_arrange.workspaces->items[i], output);
+		}
+	}
+	arrange_popups(root->layers.popup);
+}
+
+// Hand the set of workspaces touched by the transaction to the animation. The
+// first step re-arranges everything, the rest only those workspaces.
+static void animation_arrange_set(struct sway_transaction *transaction) {
+	if (!animation_arrange.workspaces) {
+		animation_arrange.workspaces = create_list();
+	}
+	animation_arrange.workspaces->length = 0;
+	for (int i = 0; i < transaction->animated->length; ++i) {
+		struct sway_workspace *ws = transaction->animated->items[i];
+		// Destroying workspaces are freed with the transaction
+		if (!ws->node.destroying) {
+			list_add(animation_arrange.workspaces, ws);
+		}
+	}
+	animation_arrange.all = transaction->animate_all;
+	animation_arrange.full = true;
 }
 
 static void transaction_commit_pending(void);
@@ -1287,6 +1539,7 @@ static void transaction_progress(void) {
 		return;
 	}
 	transaction_apply(server.queued_transaction);
+	animation_arrange_set(server.queued_transaction);
 	animation_start(NULL, NULL, animation_callback, NULL, NULL, NULL);
 	cursor_rebase_all();
 	transaction_destroy(server.queued_transaction);
@@ -1300,15 +1553,46 @@ static void transaction_progress(void) {
 	transaction_commit_pending();
 }
 
+// Xwayland views have no app_id, use their class instead
+static const char *instruction_app_id(
+		struct sway_transaction_instruction *instruction) {
+	if (!node_is_view(instruction->node)) {
+		return NULL;
+	}
+	struct sway_view *view = instruction->node->sway_container->view;
+	const char *app_id = view_get_app_id(view);
+	return app_id ? app_id : view_get_class(view);
+}
+
 static int handle_timeout(void *data) {
 	struct sway_transaction *transaction = data;
 	sway_log(SWAY_DEBUG, "Transaction %p timed out (%zi waiting)",
 			transaction, transaction->num_waiting);
+	if (transaction->num_waiting > 0) {
+		perf.txn_timeouts++;
+		for (int i = 0; i < transaction->instructions->length; ++i) {
+			struct sway_transaction_instruction *instruction =
+				transaction->instructions->items[i];
+			if (instruction->waiting &&
+					instruction->node->instruction == instruction) {
+				perf_record_txn_timeout(instruction_app_id(instruction));
+			}
+		}
+	}
 	transaction->num_waiting = 0;
 	transaction_progress();
 	return 0;
 }
 
+static bool container_is_offscreen(struct sway_container *con) {
+	for (; con; con = con->pending.parent) {
+		if (con->offscreen) {
+			return true;
+		}
+	}
+	return false;
+}
+
 static bool should_configure(struct sway_node *node,
 		struct sway_transaction_instruction *instruction) {
 	if (!node_is_view(node)) {
@@ -1351,8 +1635,11 @@ static void transaction_commit(struct sway_transaction *transaction) {
 		struct sway_transaction_instruction *instruction =
 			transaction->instructions->items[i];
 		struct sway_node *node = instruction->node;
+		// Views outside the viewport don't hold the transaction, they will
+		// have redrawn by the time they are scrolled into view.
 		bool hidden = node_is_view(node) && !node->destroying &&
-			!view_is_visible(node->sway_container->view);
+			(!view_is_visible(node->sway_container->view) ||
+			container_is_offscreen(node->sway_container));
 		if (should_configure(node, instruction)) {
 			instruction->serial = view_configure(node->sway_container->view,
 					instruction->container_state.content_x,
@@ -1373,9 +1660,7 @@ static void transaction_commit(struct sway_transaction *transaction) {
 		node->instruction = instruction;
 	}
 	transaction->num_configures = transaction->num_waiting;
-	if (debug.txn_timings) {
-		clock_gettime(CLOCK_MONOTONIC, &transaction->commit_time);
-	}
+	clock_gettime(CLOCK_MONOTONIC, &transaction->commit_time);
 	if (debug.noatomic) {
 		transaction->num_waiting = 0;
 	} else if (debug.txn_wait) {
@@ -1431,6 +1716,11 @@ static void set_instruction_ready(
 	if (instruction->waiting && transaction->num_waiting > 0 &&
 			--transaction->num_waiting == 0) {
 		sway_log(SWAY_DEBUG, "Transaction %p is ready", transaction);
+		struct timespec now, wait;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		timespec_sub(&wait, &now, &transaction->commit_time);
+		perf_record_txn_slowest(instruction_app_id(instruction),
+			timespec_to_nsec(&wait));
 		wl_event_source_timer_update(transaction->timer, 0);
 	}
 
@@ -1508,7 +1798,46 @@ static void save_animation_variables() {
 	}
 }
 
+static void transaction_add_animated_workspace(struct sway_transaction *transaction,
+		struct sway_workspace *ws) {
+	if (ws && list_find(transaction->animated, ws) == -1) {
+		list_add(transaction->animated, ws);
+	}
+}
+
+static void transaction_add_animated(struct sway_transaction *transaction,
+		struct sway_node *node) {
+	switch (node->type) {
+	case N_ROOT:
+	case N_OUTPUT:
+		// Workspaces may be shown, hidden or moved between outputs
+		transaction->animate_all = true;
+		break;
+	case N_WORKSPACE:
+		transaction_add_animated_workspace(transaction, node->sway_workspace);
+		break;
+	case N_CONTAINER:
+		transaction_add_animated_workspace(transaction,
+			node->sway_container->pending.workspace);
+		transaction_add_animated_workspace(transaction,
+			node->sway_container->current.workspace);
+		break;
+	}
+}
+
+// Commits held back by an open batch
+static struct {
+	int depth;
+	bool commit;
+	bool server_request;
+} batch = {0};
+
 static void _transaction_commit_dirty(bool server_request) {
+	if (batch.depth > 0) {
+		batch.commit = true;
+		batch.server_request |= server_request;
+		return;
+	}
 	if (!server.dirty_nodes->length) {
 		return;
 	}
@@ -1523,6 +1852,7 @@ static void _transaction_commit_dirty(bool server_request) {
 	for (int i = 0; i < server.dirty_nodes->length; ++i) {
 		struct sway_node *node = server.dirty_nodes->items[i];
 		transaction_add_node(server.pending_transaction, node, server_request);
+		transaction_add_animated(server.pending_transaction, node);
 		node->dirty = false;
 	}
 	server.dirty_nodes->length = 0;
@@ -1540,3 +1870,20 @@ void transaction_commit_dirty(void) {
 void transaction_commit_dirty_client(void) {
 	_transaction_commit_dirty(false);
 }
+
+void transaction_batch_begin(void) {
+	batch.depth++;
+}
+
+void transaction_batch_end(void) {
+	if (!sway_assert(batch.depth > 0, "Unbalanced transaction batch")) {
+		return;
+	}
+	if (--batch.depth > 0 || !batch.commit) {
+		return;
+	}
+	bool server_request = batch.server_request;
+	batch.commit = false;
+	batch.server_request = false;
+	_transaction_commit_dirty(server_request);
+}
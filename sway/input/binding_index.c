@@ -0,0 +1,198 @@
+#include <stdlib.h>
+#include <string.h>
+#include "sway/config.h"
+#include "sway/input/keyboard.h"
+#include "list.h"
+#include "log.h"
+
+void binding_index_invalidate(struct sway_mode *mode) {
+	mode->keysym_index.valid = false;
+	mode->keycode_index.valid = false;
+}
+
+void binding_index_finish(struct sway_binding_index *index) {
+	free(index->positions);
+	index->positions = NULL;
+	index->valid = false;
+}
+
+static int binding_index_hash(uint32_t modifiers, bool release, uint32_t key) {
+	uint32_t hash = key * 2654435761u;
+	hash ^= modifiers * 0x9e3779b9u;
+	hash ^= release ? 0x85ebca6bu : 0;
+	return (hash >> 16) & (SWAY_BINDING_INDEX_BUCKETS - 1);
+}
+
+static int binding_index_hash_binding(struct sway_binding *binding) {
+	// Keys are sorted, and a binding can only match when its first key is
+	// either the first pressed key or the newly-pressed key
+	uint32_t key = binding->keys->length > 0 ?
+		*(uint32_t *)binding->keys->items[0] : 0;
+	return binding_index_hash(binding->modifiers,
+			binding->flags & BINDING_RELEASE, key);
+}
+
+static void binding_index_rebuild(struct sway_binding_index *index,
+		list_t *bindings) {
+	free(index->positions);
+	index->positions = NULL;
+	memset(index->offsets, 0, sizeof(index->offsets));
+	if (bindings->length > 0) {
+		index->positions = calloc(bindings->length, sizeof(int));
+		if (!index->positions) {
+			sway_log(SWAY_ERROR, "Unable to allocate binding index");
+			return;
+		}
+	}
+
+	// Counting sort by bucket, which keeps the list order within buckets
+	for (int i = 0; i < bindings->length; ++i) {
+		++index->offsets[binding_index_hash_binding(bindings->items[i]) + 1];
+	}
+	for (int i = 0; i < SWAY_BINDING_INDEX_BUCKETS; ++i) {
+		index->offsets[i + 1] += index->offsets[i];
+	}
+	int fill[SWAY_BINDING_INDEX_BUCKETS];
+	memcpy(fill, index->offsets, sizeof(fill));
+	for (int i = 0; i < bindings->length; ++i) {
+		int bucket = binding_index_hash_binding(bindings->items[i]);
+		index->positions[fill[bucket]++] = i;
+	}
+	index->valid = true;
+}
+
+int binding_index_bucket(struct sway_binding_index *index, list_t *bindings,
+		uint32_t modifiers, bool release, uint32_t key) {
+	if (!index->valid) {
+		binding_index_rebuild(index, bindings);
+	}
+	return binding_index_hash(modifiers, release, key);
+}
+
+/**
+ * If one exists, finds a binding which matches the shortcut model state,
+ * current modifiers, release state, and locked state.
+ */
+void binding_index_get_active(const struct sway_shortcut_state *state,
+		list_t *bindings, struct sway_binding_index *index,
+		struct sway_binding **current_binding,
+		uint32_t modifiers, bool release, bool locked, bool inhibited,
+		const char *input, bool exact_input, xkb_layout_index_t group) {
+	// Only bindings whose first key is the first pressed key or the
+	// newly-pressed key can match; walk both buckets merged in list order
+	int bucket_a = binding_index_bucket(index, bindings, modifiers, release,
+			state->pressed_keys[0]);
+	int bucket_b = binding_index_bucket(index, bindings, modifiers, release,
+			state->current_key);
+	if (!index->valid) {
+		return;
+	}
+	int a = index->offsets[bucket_a], a_end = index->offsets[bucket_a + 1];
+	int b = index->offsets[bucket_b], b_end = index->offsets[bucket_b + 1];
+	if (bucket_a == bucket_b) {
+		b = b_end;
+	}
+	while (a < a_end || b < b_end) {
+		int i;
+		if (b >= b_end || (a < a_end &&
+				index->positions[a] < index->positions[b])) {
+			i = index->positions[a++];
+		} else {
+			i = index->positions[b++];
+		}
+		struct sway_binding *binding = bindings->items[i];
+		bool binding_locked = (binding->flags & BINDING_LOCKED) != 0;
+		bool binding_inhibited = (binding->flags & BINDING_INHIBITED) != 0;
+		bool binding_release = binding->flags & BINDING_RELEASE;
+
+		if (modifiers ^ binding->modifiers ||
+				release != binding_release ||
+				locked > binding_locked ||
+				inhibited > binding_inhibited ||
+				(binding->group != XKB_LAYOUT_INVALID &&
+				 binding->group != group) ||
+				(strcmp(binding->input, input) != 0 &&
+				 (strcmp(binding->input, "*") != 0 || exact_input))) {
+			continue;
+		}
+
+		bool match = false;
+		if (state->npressed == (size_t)binding->keys->length) {
+			match = true;
+			for (size_t j = 0; j < state->npressed; j++) {
+				uint32_t key = *(uint32_t *)binding->keys->items[j];
+				if (key != state->pressed_keys[j]) {
+					match = false;
+					break;
+				}
+			}
+		} else if (binding->keys->length == 1) {
+			/*
+			 * If no multiple-key binding has matched, try looking for
+			 * single-key bindings that match the newly-pressed key.
+			 */
+			match = state->current_key == *(uint32_t *)binding->keys->items[0];
+		}
+		if (!match) {
+			continue;
+		}
+
+		if (*current_binding) {
+			if (*current_binding == binding) {
+				continue;
+			}
+
+			bool current_locked =
+				((*current_binding)->flags & BINDING_LOCKED) != 0;
+			bool current_inhibited =
+				((*current_binding)->flags & BINDING_INHIBITED) != 0;
+			bool current_input = strcmp((*current_binding)->input, input) == 0;
+			bool current_group_set =
+				(*current_binding)->group != XKB_LAYOUT_INVALID;
+			bool binding_input = strcmp(binding->input, input) == 0;
+			bool binding_group_set = binding->group != XKB_LAYOUT_INVALID;
+
+			if (current_input == binding_input
+					&& current_locked == binding_locked
+					&& current_inhibited == binding_inhibited
+					&& current_group_set == binding_group_set) {
+				sway_log(SWAY_DEBUG,
+						"Encountered conflicting bindings %d and %d",
+						(*current_binding)->order, binding->order);
+				continue;
+			}
+
+			if (current_input && !binding_input) {
+				continue; // Prefer the correct input
+			}
+
+			if (current_input == binding_input &&
+				   (*current_binding)->group == group) {
+				continue; // Prefer correct group for matching inputs
+			}
+
+			if (current_input == binding_input &&
+					current_group_set == binding_group_set &&
+					current_locked == locked) {
+				continue; // Prefer correct lock state for matching input+group
+			}
+
+			if (current_input == binding_input &&
+					current_group_set == binding_group_set &&
+					current_locked == binding_locked &&
+					current_inhibited == inhibited) {
+				// Prefer correct inhibition state for matching
+				// input+group+locked
+				continue;
+			}
+		}
+
+		*current_binding = binding;
+		if (strcmp((*current_binding)->input, input) == 0 &&
+				(((*current_binding)->flags & BINDING_LOCKED) == locked) &&
+				(((*current_binding)->flags & BINDING_INHIBITED) == inhibited) &&
+				(*current_binding)->group == group) {
+			return; // If a perfect match is found, quit searching
+		}
+	}
+}
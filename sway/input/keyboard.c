@@ -151,112 +151,6 @@ static bool update_shortcut_state(struct sway_shortcut_state *state,
 	return false;
 }
 
-/**
- * If one exists, finds a binding which matches the shortcut model state,
- * current modifiers, release state, and locked state.
- */
-static void get_active_binding(const struct sway_shortcut_state *state,
-		list_t *bindings, struct sway_binding **current_binding,
-		uint32_t modifiers, bool release, bool locked, bool inhibited,
-		const char *input, bool exact_input, xkb_layout_index_t group) {
-	for (int i = 0; i < bindings->length; ++i) {
-		struct sway_binding *binding = bindings->items[i];
-		bool binding_locked = (binding->flags & BINDING_LOCKED) != 0;
-		bool binding_inhibited = (binding->flags & BINDING_INHIBITED) != 0;
-		bool binding_release = binding->flags & BINDING_RELEASE;
-
-		if (modifiers ^ binding->modifiers ||
-				release != binding_release ||
-				locked > binding_locked ||
-				inhibited > binding_inhibited ||
-				(binding->group != XKB_LAYOUT_INVALID &&
-				 binding->group != group) ||
-				(strcmp(binding->input, input) != 0 &&
-				 (strcmp(binding->input, "*") != 0 || exact_input))) {
-			continue;
-		}
-
-		bool match = false;
-		if (state->npressed == (size_t)binding->keys->length) {
-			match = true;
-			for (size_t j = 0; j < state->npressed; j++) {
-				uint32_t key = *(uint32_t *)binding->keys->items[j];
-				if (key != state->pressed_keys[j]) {
-					match = false;
-					break;
-				}
-			}
-		} else if (binding->keys->length == 1) {
-			/*
-			 * If no multiple-key binding has matched, try looking for
-			 * single-key bindings that match the newly-pressed key.
-			 */
-			match = state->current_key == *(uint32_t *)binding->keys->items[0];
-		}
-		if (!match) {
-			continue;
-		}
-
-		if (*current_binding) {
-			if (*current_binding == binding) {
-				continue;
-			}
-
-			bool current_locked =
-				((*current_binding)->flags & BINDING_LOCKED) != 0;
-			bool current_inhibited =
-				((*current_binding)->flags & BINDING_INHIBITED) != 0;
-			bool current_input = strcmp((*current_binding)->input, input) == 0;
-			bool current_group_set =
-				(*current_binding)->group != XKB_LAYOUT_INVALID;
-			bool binding_input = strcmp(binding->input, input) == 0;
-			bool binding_group_set = binding->group != XKB_LAYOUT_INVALID;
-
-			if (current_input == binding_input
-					&& current_locked == binding_locked
-					&& current_inhibited == binding_inhibited
-					&& current_group_set == binding_group_set) {
-				sway_log(SWAY_DEBUG,
-						"Encountered conflicting bindings %d and %d",
-						(*current_binding)->order, binding->order);
-				continue;
-			}
-
-			if (current_input && !binding_input) {
-				continue; // Prefer the correct input
-			}
-
-			if (current_input == binding_input &&
-				   (*current_binding)->group == group) {
-				continue; // Prefer correct group for matching inputs
-			}
-
-			if (current_input == binding_input &&
-					current_group_set == binding_group_set &&
-					current_locked == locked) {
-				continue; // Prefer correct lock state for matching input+group
-			}
-
-			if (current_input == binding_input &&
-					current_group_set == binding_group_set &&
-					current_locked == binding_locked &&
-					current_inhibited == inhibited) {
-				// Prefer correct inhibition state for matching
-				// input+group+locked
-				continue;
-			}
-		}
-
-		*current_binding = binding;
-		if (strcmp((*current_binding)->input, input) == 0 &&
-				(((*current_binding)->flags & BINDING_LOCKED) == locked) &&
-				(((*current_binding)->flags & BINDING_INHIBITED) == inhibited) &&
-				(*current_binding)->group == group) {
-			return; // If a perfect match is found, quit searching
-		}
-	}
-}
-
 /**
  * Execute a built-in, hardcoded compositor binding. These are triggered from a
  * single keysym.
@@ -468,18 +362,21 @@ static void handle_key_event(struct sway_keyboard *keyboard,
 	bool handled = false;
 	// Identify active release binding
 	struct sway_binding *binding_released = NULL;
-	get_active_binding(&keyboard->state_keycodes,
-			config->current_mode->keycode_bindings, &binding_released,
+	binding_index_get_active(&keyboard->state_keycodes,
+			config->current_mode->keycode_bindings,
+			&config->current_mode->keycode_index, &binding_released,
 			keyinfo.code_modifiers, true, locked,
 			shortcuts_inhibited, device_identifier,
 			exact_identifier, keyboard->effective_layout);
-	get_active_binding(&keyboard->state_keysyms_raw,
-			config->current_mode->keysym_bindings, &binding_released,
+	binding_index_get_active(&keyboard->state_keysyms_raw,
+			config->current_mode->keysym_bindings,
+			&config->current_mode->keysym_index, &binding_released,
 			keyinfo.raw_modifiers, true, locked,
 			shortcuts_inhibited, device_identifier,
 			exact_identifier, keyboard->effective_layout);
-	get_active_binding(&keyboard->state_keysyms_translated,
-			config->current_mode->keysym_bindings, &binding_released,
+	binding_index_get_active(&keyboard->state_keysyms_translated,
+			config->current_mode->keysym_bindings,
+			&config->current_mode->keysym_index, &binding_released,
 			keyinfo.translated_modifiers, true, locked,
 			shortcuts_inhibited, device_identifier,
 			exact_identifier, keyboard->effective_layout);
@@ -500,18 +397,21 @@ static void handle_key_event(struct sway_keyboard *keyboard,
 	// Identify and execute active pressed binding
 	struct sway_binding *binding = NULL;
 	if (event->state == WL_KEYBOARD_KEY_STATE_PRESSED) {
-		get_active_binding(&keyboard->state_keycodes,
-				config->current_mode->keycode_bindings, &binding,
+		binding_index_get_active(&keyboard->state_keycodes,
+				config->current_mode->keycode_bindings,
+				&config->current_mode->keycode_index, &binding,
 				keyinfo.code_modifiers, false, locked,
 				shortcuts_inhibited, device_identifier,
 				exact_identifier, keyboard->effective_layout);
-		get_active_binding(&keyboard->state_keysyms_raw,
-				config->current_mode->keysym_bindings, &binding,
+		binding_index_get_active(&keyboard->state_keysyms_raw,
+				config->current_mode->keysym_bindings,
+				&config->current_mode->keysym_index, &binding,
 				keyinfo.raw_modifiers, false, locked,
 				shortcuts_inhibited, device_identifier,
 				exact_identifier, keyboard->effective_layout);
-		get_active_binding(&keyboard->state_keysyms_translated,
-				config->current_mode->keysym_bindings, &binding,
+		binding_index_get_active(&keyboard->state_keysyms_translated,
+				config->current_mode->keysym_bindings,
+				&config->current_mode->keysym_index, &binding,
 				keyinfo.translated_modifiers, false, locked,
 				shortcuts_inhibited, device_identifier,
 				exact_identifier, keyboard->effective_layout);
@@ -325,6 +325,24 @@ static void handle_seat_node_destroy(struct wl_listener *listener, void *data) {
 	}
 }
 
+static struct sway_seat_node *seat_node_find(
+		struct sway_seat *seat, struct sway_node *node) {
+	// Every seat node listens to the destruction of its node, so the node's
+	// listeners lead to it without walking the focus stack
+	struct wl_listener *listener;
+	wl_list_for_each(listener, &node->events.destroy.listener_list, link) {
+		if (listener->notify != handle_seat_node_destroy) {
+			continue;
+		}
+		struct sway_seat_node *seat_node =
+			wl_container_of(listener, seat_node, destroy);
+		if (seat_node->seat == seat) {
+			return seat_node;
+		}
+	}
+	return NULL;
+}
+
 static struct sway_seat_node *seat_node_from_node(
 		struct sway_seat *seat, struct sway_node *node) {
 	if (node->type == N_ROOT || node->type == N_OUTPUT) {
@@ -332,11 +350,9 @@ static struct sway_seat_node *seat_node_from_node(
 		return NULL;
 	}
 
-	struct sway_seat_node *seat_node = NULL;
-	wl_list_for_each(seat_node, &seat->focus_stack, link) {
-		if (seat_node->node == node) {
-			return seat_node;
-		}
+	struct sway_seat_node *seat_node = seat_node_find(seat, node);
+	if (seat_node) {
+		return seat_node;
 	}
 
 	seat_node = calloc(1, sizeof(struct sway_seat_node));
@@ -347,6 +363,8 @@ static struct sway_seat_node *seat_node_from_node(
 
 	seat_node->node = node;
 	seat_node->seat = seat;
+	// New nodes go to the bottom of the stack, below every other serial
+	seat_node->serial = --seat->focus_serial_bottom;
 	wl_list_insert(seat->focus_stack.prev, &seat_node->link);
 	wl_signal_add(&node->events.destroy, &seat_node->destroy);
 	seat_node->destroy.notify = handle_seat_node_destroy;
@@ -490,14 +508,21 @@ static void handle_request_set_primary_selection(struct wl_listener *listener,
 	wlr_seat_set_primary_selection(seat->wlr_seat, event->source, event->serial);
 }
 
+// Move the node to the top of the focus stack
+static void seat_node_raise(struct sway_seat_node *seat_node) {
+	struct sway_seat *seat = seat_node->seat;
+	seat_node->serial = ++seat->focus_serial_top;
+	wl_list_remove(&seat_node->link);
+	wl_list_insert(&seat->focus_stack, &seat_node->link);
+}
+
 static void collect_focus_iter(struct sway_node *node, void *data) {
 	struct sway_seat *seat = data;
 	struct sway_seat_node *seat_node = seat_node_from_node(seat, node);
 	if (!seat_node) {
 		return;
 	}
-	wl_list_remove(&seat_node->link);
-	wl_list_insert(&seat->focus_stack, &seat_node->link);
+	seat_node_raise(seat_node);
 }
 
 static void collect_focus_workspace_iter(struct sway_workspace *workspace,
@@ -1116,8 +1141,7 @@ static void set_workspace(struct sway_seat *seat,
 
 void seat_set_raw_focus(struct sway_seat *seat, struct sway_node *node) {
 	struct sway_seat_node *seat_node = seat_node_from_node(seat, node);
-	wl_list_remove(&seat_node->link);
-	wl_list_insert(&seat->focus_stack, &seat_node->link);
+	seat_node_raise(seat_node);
 	node_set_dirty(node);
 
 	// If focusing a scratchpad container that is fullscreen global, parent
@@ -1368,8 +1392,14 @@ struct sway_node *seat_get_focus_inactive(struct sway_seat *seat,
 	if (node_is_view(node)) {
 		return node;
 	}
+	// Workspaces are only below the root and outputs
+	bool skip_workspaces = node->type == N_WORKSPACE ||
+		node->type == N_CONTAINER;
 	struct sway_seat_node *current;
 	wl_list_for_each(current, &seat->focus_stack, link) {
+		if (skip_workspaces && current->node->type == N_WORKSPACE) {
+			continue;
+		}
 		if (node_has_ancestor(current->node, node)) {
 			return current->node;
 		}
@@ -1388,9 +1418,11 @@ struct sway_container *seat_get_focus_inactive_tiling(struct sway_seat *seat,
 	struct sway_seat_node *current;
 	wl_list_for_each(current, &seat->focus_stack, link) {
 		struct sway_node *node = current->node;
+		// Compare the workspace first, finding the floating ancestor walks
+		// the tree
 		if (node->type == N_CONTAINER &&
-				!container_is_floating_or_child(node->sway_container) &&
-				node->sway_container->pending.workspace == workspace) {
+				node->sway_container->pending.workspace == workspace &&
+				!container_is_floating_or_child(node->sway_container)) {
 			return node->sway_container;
 		}
 	}
@@ -1406,8 +1438,8 @@ struct sway_container *seat_get_focus_inactive_floating(struct sway_seat *seat,
 	wl_list_for_each(current, &seat->focus_stack, link) {
 		struct sway_node *node = current->node;
 		if (node->type == N_CONTAINER &&
-				container_is_floating_or_child(node->sway_container) &&
-				node->sway_container->pending.workspace == workspace) {
+				node->sway_container->pending.workspace == workspace &&
+				container_is_floating_or_child(node->sway_container)) {
 			return node->sway_container;
 		}
 	}
@@ -1419,6 +1451,27 @@ struct sway_node *seat_get_active_tiling_child(struct sway_seat *seat,
 	if (node_is_view(parent)) {
 		return parent;
 	}
+	list_t *children = NULL;
+	if (parent->type == N_WORKSPACE) {
+		children = parent->sway_workspace->tiling;
+	} else if (parent->type == N_CONTAINER) {
+		children = parent->sway_container->pending.children;
+	}
+	if (children) {
+		// The focus stack is ordered by serial, so the most recently focused
+		// child is found among the children instead of the whole stack
+		struct sway_seat_node *active = NULL;
+		for (int i = 0; i < children->length; ++i) {
+			struct sway_container *child = children->items[i];
+			struct sway_seat_node *seat_node =
+				seat_node_find(seat, &child->node);
+			if (seat_node && (!active || seat_node->serial > active->serial) &&
+					node_get_parent(&child->node) == parent) {
+				active = seat_node;
+			}
+		}
+		return active ? active->node : NULL;
+	}
 	struct sway_seat_node *current;
 	wl_list_for_each(current, &seat->focus_stack, link) {
 		struct sway_node *node = current->node;
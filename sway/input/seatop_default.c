@@ -908,8 +908,8 @@ static void gesture_binding_execute(struct sway_seat *seat,
 	sway_log(SWAY_DEBUG, "executing gesture binding: %s", description);
 	free(description);
 
-	seat_execute_command(seat, dummy_binding);
-
+	// The command may unbind the gesture, don't touch it afterwards
+	seat_execute_binding_command(seat, dummy_binding, &binding->program);
 	free(dummy_binding);
 }
 
@@ -70,7 +70,9 @@ static void execute_binding(struct sway_switch *sway_switch) {
 		dummy_binding->flags = matched_binding->flags;
 		dummy_binding->command = matched_binding->command;
 
-		seat_execute_command(seat, dummy_binding);
+		// The command may unbind the switch, don't touch it afterwards
+		seat_execute_binding_command(seat, dummy_binding,
+			&matched_binding->program);
 		free(dummy_binding);
 	}
 }
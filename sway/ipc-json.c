@@ -3,6 +3,7 @@
 #include <json.h>
 #include <libevdev/libevdev.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <wlr/config.h>
 #include <wlr/types/wlr_content_type_v1.h>
 #include <wlr/types/wlr_output.h>
@@ -12,11 +13,13 @@
 #include "log.h"
 #include "sway/config.h"
 #include "sway/ipc-json.h"
+#include "sway/ipc-server.h"
 #include "sway/server.h"
 #include "sway/tree/container.h"
 #include "sway/tree/view.h"
 #include "sway/tree/workspace.h"
 #include "sway/output.h"
+#include "sway/perf.h"
 #include "sway/input/input-manager.h"
 #include "sway/input/cursor.h"
 #include "sway/input/seat.h"
@@ -746,6 +749,102 @@ static void ipc_json_describe_container(struct sway_container *c, json_object *o
 	}
 }
 
+/**
+ * The focus order of the children of every node, read from the seat focus
+ * stack in a single pass. While a tree is being described, the focus arrays
+ * are taken from here instead of walking the focus stack for each node.
+ */
+struct focus_index_entry {
+	struct sway_node *parent;
+	size_t order;
+	size_t id;
+};
+
+struct focus_index {
+	struct focus_index_entry *entries;
+	size_t length;
+};
+
+static struct focus_index *focus_index = NULL;
+
+static int focus_index_entry_cmp(const void *_a, const void *_b) {
+	const struct focus_index_entry *a = _a, *b = _b;
+	if (a->parent != b->parent) {
+		return (uintptr_t)a->parent < (uintptr_t)b->parent ? -1 : 1;
+	}
+	return a->order < b->order ? -1 : a->order > b->order;
+}
+
+static void focus_index_add(struct focus_index *index,
+		struct sway_node *parent, size_t id) {
+	index->entries[index->length] = (struct focus_index_entry){
+		.parent = parent,
+		.order = index->length,
+		.id = id,
+	};
+	index->length++;
+}
+
+static bool focus_index_init(struct focus_index *index,
+		struct sway_seat *seat) {
+	// Each node is listed under its parent, and its output under the root
+	size_t max = wl_list_length(&seat->focus_stack) * 2;
+	index->length = 0;
+	index->entries = calloc(max ? max : 1, sizeof(*index->entries));
+	list_t *outputs = create_list();
+	if (!index->entries || !outputs) {
+		free(index->entries);
+		list_free(outputs);
+		return false;
+	}
+
+	struct sway_seat_node *current;
+	wl_list_for_each(current, &seat->focus_stack, link) {
+		struct sway_node *node = current->node;
+		struct sway_node *parent = node_get_parent(node);
+		if (parent && parent != &root->node) {
+			focus_index_add(index, parent, node->id);
+		}
+
+		// The root lists each output once
+		struct sway_output *output = node_get_output(node);
+		if (output && list_find(outputs, output) == -1) {
+			list_add(outputs, output);
+			focus_index_add(index, &root->node, output->node.id);
+		}
+	}
+	list_free(outputs);
+
+	qsort(index->entries, index->length, sizeof(*index->entries),
+		focus_index_entry_cmp);
+	return true;
+}
+
+static void focus_index_finish(struct focus_index *index) {
+	free(index->entries);
+	index->entries = NULL;
+	index->length = 0;
+}
+
+static void focus_index_describe(struct focus_index *index,
+		struct sway_node *node, json_object *focus) {
+	// First entry of node
+	size_t lo = 0, hi = index->length;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if ((uintptr_t)index->entries[mid].parent < (uintptr_t)node) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	for (size_t i = lo; i < index->length &&
+			index->entries[i].parent == node; ++i) {
+		json_object_array_add(focus,
+			json_object_new_int(index->entries[i].id));
+	}
+}
+
 struct focus_inactive_data {
 	struct sway_node *node;
 	json_object *object;
@@ -790,11 +889,15 @@ json_object *ipc_json_describe_node(struct sway_node *node) {
 	}
 
 	json_object *focus = json_object_new_array();
-	struct focus_inactive_data data = {
-		.node = node,
-		.object = focus,
-	};
-	seat_for_each_node(seat, focus_inactive_children_iterator, &data);
+	if (focus_index) {
+		focus_index_describe(focus_index, node, focus);
+	} else {
+		struct focus_inactive_data data = {
+			.node = node,
+			.object = focus,
+		};
+		seat_for_each_node(seat, focus_inactive_children_iterator, &data);
+	}
 
 	json_object *object = ipc_json_create_node((int)node->id,
 				ipc_json_node_type_description(node->type), name, focused, focus, &box);
@@ -817,6 +920,17 @@ json_object *ipc_json_describe_node(struct sway_node *node) {
 }
 
 json_object *ipc_json_describe_node_recursive(struct sway_node *node) {
+	// The outermost call indexes the focus stack for the whole subtree
+	struct focus_index index;
+	if (!focus_index && focus_index_init(&index,
+				input_manager_get_default_seat())) {
+		focus_index = &index;
+		json_object *object = ipc_json_describe_node_recursive(node);
+		focus_index = NULL;
+		focus_index_finish(&index);
+		return object;
+	}
+
 	json_object *object = ipc_json_describe_node(node);
 	int i;
 
@@ -1525,3 +1639,180 @@ json_object *ipc_json_describe_trails() {
 
 	return object;
 }
+
+// Times are in nanoseconds. Only the non empty buckets are listed, as pairs of
+// the bucket upper bound and its count.
+static json_object *ipc_json_describe_histogram(
+		const struct sway_perf_histogram *histogram) {
+	json_object *object = json_object_new_object();
+	json_object_object_add(object, "count",
+		json_object_new_int64(histogram->count));
+	json_object_object_add(object, "min", json_object_new_int64(histogram->min));
+	json_object_object_add(object, "max", json_object_new_int64(histogram->max));
+	json_object_object_add(object, "p50",
+		json_object_new_int64(perf_histogram_percentile(histogram, 50.0)));
+	json_object_object_add(object, "p90",
+		json_object_new_int64(perf_histogram_percentile(histogram, 90.0)));
+	json_object_object_add(object, "p99",
+		json_object_new_int64(perf_histogram_percentile(histogram, 99.0)));
+	json_object *buckets = json_object_new_array();
+	for (int i = 0; i < PERF_HISTOGRAM_BUCKETS; ++i) {
+		if (histogram->buckets[i] == 0) {
+			continue;
+		}
+		json_object *bucket = json_object_new_array();
+		json_object_array_add(bucket,
+			json_object_new_int64(perf_histogram_bucket_bound(i)));
+		json_object_array_add(bucket,
+			json_object_new_int64(histogram->buckets[i]));
+		json_object_array_add(buckets, bucket);
+	}
+	json_object_object_add(object, "buckets", buckets);
+	return object;
+}
+
+json_object *ipc_json_describe_perf(void) {
+	json_object *object = json_object_new_object();
+
+	for (int i = 0; i < PERF_METRIC_COUNT; ++i) {
+		json_object_object_add(object, perf_metric_name(i),
+			ipc_json_describe_histogram(&perf.histograms[i]));
+	}
+	json_object_object_add(object, "transaction_timeouts",
+		json_object_new_int64(perf.txn_timeouts));
+
+	json_object *clients = json_object_new_array();
+	for (int i = 0; perf.clients && i < perf.clients->length; ++i) {
+		struct sway_perf_client *client = perf.clients->items[i];
+		json_object *c = json_object_new_object();
+		json_object_object_add(c, "app_id", client->app_id ?
+			json_object_new_string(client->app_id) : NULL);
+		json_object_object_add(c, "slowest", json_object_new_int64(client->slowest));
+		json_object_object_add(c, "timeouts", json_object_new_int64(client->timeouts));
+		json_object_object_add(c, "wait_total", json_object_new_int64(client->wait_total));
+		json_object_object_add(c, "wait_max", json_object_new_int64(client->wait_max));
+		json_object_array_add(clients, c);
+	}
+	json_object_object_add(object, "clients", clients);
+
+	json_object *outputs = json_object_new_array();
+	for (int i = 0; i < root->outputs->length; ++i) {
+		struct sway_output *output = root->outputs->items[i];
+		struct sway_output_perf *stats = &output->perf;
+		json_object *o = json_object_new_object();
+		json_object_object_add(o, "name",
+			json_object_new_string(output->wlr_output->name));
+		json_object_object_add(o, "frames", json_object_new_int64(stats->frames));
+		json_object_object_add(o, "missed_vblanks",
+			json_object_new_int64(stats->missed_vblanks));
+		json_object_object_add(o, "build_state",
+			ipc_json_describe_histogram(&stats->build_state));
+		json_object_object_add(o, "render",
+			ipc_json_describe_histogram(&stats->render));
+		json_object_object_add(o, "present_latency",
+			ipc_json_describe_histogram(&stats->present_latency));
+		json_object_array_add(outputs, o);
+	}
+	json_object_object_add(object, "outputs", outputs);
+
+	return object;
+}
+
+static json_object *ipc_json_describe_node_ids(list_t *nodes) {
+	json_object *array = json_object_new_array();
+	for (int i = 0; nodes && i < nodes->length; ++i) {
+		struct sway_container *con = nodes->items[i];
+		json_object_array_add(array, json_object_new_int(con->node.id));
+	}
+	return array;
+}
+
+static json_object *ipc_json_describe_workspace_ids(list_t *workspaces) {
+	json_object *array = json_object_new_array();
+	for (int i = 0; workspaces && i < workspaces->length; ++i) {
+		struct sway_workspace *ws = workspaces->items[i];
+		json_object_array_add(array, json_object_new_int(ws->node.id));
+	}
+	return array;
+}
+
+// Describes the applied (current) state of a node that changed in a
+// transaction. Only the properties named in changes are included.
+json_object *ipc_json_describe_tree_change(struct sway_node *node, uint32_t changes) {
+	json_object *object = json_object_new_object();
+
+	json_object *change = json_object_new_array();
+	static const char *names[] = {
+		"new", "close", "move", "geometry", "focus", "children",
+	};
+	for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+		if (changes & (1 << i)) {
+			json_object_array_add(change, json_object_new_string(names[i]));
+		}
+	}
+	json_object_object_add(object, "change", change);
+	json_object_object_add(object, "id", json_object_new_int(node->id));
+	json_object_object_add(object, "type",
+		json_object_new_string(ipc_json_node_type_description(node->type)));
+
+	if (changes & IPC_TREE_CLOSE) {
+		return object;
+	}
+	if (changes & IPC_TREE_NEW) {
+		json_object_object_add(object, "node", ipc_json_describe_node(node));
+	}
+
+	struct wlr_box box = {0};
+	bool focused = false;
+	switch (node->type) {
+	case N_ROOT:
+		break;
+	case N_OUTPUT:;
+		struct sway_output *output = node->sway_output;
+		box = (struct wlr_box){ output->lx, output->ly, output->width, output->height };
+		if (changes & IPC_TREE_CHILDREN) {
+			json_object_object_add(object, "nodes",
+				ipc_json_describe_workspace_ids(output->current.workspaces));
+		}
+		break;
+	case N_WORKSPACE:;
+		struct sway_workspace *ws = node->sway_workspace;
+		box = (struct wlr_box){ ws->current.x, ws->current.y,
+			ws->current.width, ws->current.height };
+		focused = ws->current.focused;
+		if (changes & IPC_TREE_CHILDREN) {
+			json_object_object_add(object, "nodes",
+				ipc_json_describe_node_ids(ws->current.tiling));
+			json_object_object_add(object, "floating_nodes",
+				ipc_json_describe_node_ids(ws->current.floating));
+		}
+		break;
+	case N_CONTAINER:;
+		struct sway_container *con = node->sway_container;
+		box = (struct wlr_box){ con->current.x, con->current.y,
+			con->current.width, con->current.height };
+		focused = con->current.focused;
+		if (changes & IPC_TREE_MOVE) {
+			// null while the container is in the scratchpad
+			struct sway_node *parent = con->current.parent ?
+				&con->current.parent->node : con->current.workspace ?
+				&con->current.workspace->node : NULL;
+			json_object_object_add(object, "parent",
+				parent ? json_object_new_int(parent->id) : NULL);
+		}
+		if (changes & IPC_TREE_CHILDREN) {
+			json_object_object_add(object, "nodes",
+				ipc_json_describe_node_ids(con->current.children));
+		}
+		break;
+	}
+
+	if (changes & IPC_TREE_GEOMETRY) {
+		json_object_object_add(object, "rect", ipc_json_create_rect(&box));
+	}
+	if (changes & IPC_TREE_FOCUS) {
+		json_object_object_add(object, "focused", json_object_new_boolean(focused));
+	}
+
+	return object;
+}
@@ -11,6 +11,7 @@
 #include <string.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <unistd.h>
 #include <wayland-server-core.h>
@@ -36,20 +37,44 @@ static struct wl_event_source *ipc_event_source =  NULL;
 static struct sockaddr_un *ipc_sockaddr = NULL;
 static list_t *ipc_client_list = NULL;
 static struct wl_listener ipc_display_destroy;
+// Sends the perf event periodically while there are subscribers
+static struct wl_event_source *ipc_perf_timer = NULL;
+
+#define IPC_PERF_EVENT_INTERVAL_MS 1000
+
+// Parts of the state event that changed, sent together once the compositor is
+// done with the changes
+static struct {
+	struct wl_event_source *idle;
+	bool workspaces;
+	bool scroller;
+	bool trails;
+} ipc_state = {0};
 
 static const char ipc_magic[] = {'i', '3', '-', 'i', 'p', 'c'};
 
 #define IPC_HEADER_SIZE (sizeof(ipc_magic) + 8)
 
+// Maximum number of queued messages handed to a single writev()
+#define IPC_WRITE_IOV_MAX 64
+
+// A message with its header, ready to be written. Events are queued by
+// reference for every subscribed client, so they are only copied once.
+struct ipc_message {
+	int refs;
+	size_t size;
+	char data[];
+};
+
 struct ipc_client {
 	struct wl_event_source *event_source;
 	struct wl_event_source *writable_event_source;
 	struct sway_server *server;
 	int fd;
-	enum ipc_command_type subscribed_events;
-	size_t write_buffer_len;
-	size_t write_buffer_size;
-	char *write_buffer;
+	uint64_t subscribed_events;
+	list_t *write_queue; // struct ipc_message *
+	size_t write_offset; // bytes of the first queued message already written
+	size_t write_queue_size; // bytes queued and not written yet
 	// The following are for storing data between event_loop calls
 	uint32_t pending_length;
 	enum ipc_command_type pending_type;
@@ -68,6 +93,14 @@ static void handle_display_destroy(struct wl_listener *listener, void *data) {
 	if (ipc_event_source) {
 		wl_event_source_remove(ipc_event_source);
 	}
+	if (ipc_perf_timer) {
+		wl_event_source_remove(ipc_perf_timer);
+		ipc_perf_timer = NULL;
+	}
+	if (ipc_state.idle) {
+		wl_event_source_remove(ipc_state.idle);
+		ipc_state.idle = NULL;
+	}
 	close(ipc_socket);
 	unlink(ipc_sockaddr->sun_path);
 
@@ -185,14 +218,9 @@ int ipc_handle_connection(int fd, uint32_t mask, void *data) {
 			client_fd, WL_EVENT_READABLE, ipc_client_handle_readable, client);
 	client->writable_event_source = NULL;
 
-	client->write_buffer_size = 128;
-	client->write_buffer_len = 0;
-	client->write_buffer = malloc(client->write_buffer_size);
-	if (!client->write_buffer) {
-		sway_log(SWAY_ERROR, "Unable to allocate ipc client write buffer");
-		close(client_fd);
-		return 0;
-	}
+	client->write_queue = create_list();
+	client->write_offset = 0;
+	client->write_queue_size = 0;
 
 	sway_log(SWAY_DEBUG, "New client: fd %d", client_fd);
 	list_add(ipc_client_list, client);
@@ -275,26 +303,92 @@ static bool ipc_has_event_listeners(enum ipc_command_type event) {
 	return false;
 }
 
+static struct ipc_message *ipc_message_create(enum ipc_command_type payload_type,
+		const char *payload, uint32_t payload_length) {
+	struct ipc_message *message =
+		malloc(sizeof(*message) + IPC_HEADER_SIZE + payload_length);
+	if (!message) {
+		sway_log(SWAY_ERROR, "Unable to allocate ipc message");
+		return NULL;
+	}
+	message->refs = 1;
+	message->size = IPC_HEADER_SIZE + payload_length;
+
+	char *data = message->data;
+	memcpy(data, ipc_magic, sizeof(ipc_magic));
+	memcpy(data + sizeof(ipc_magic), &payload_length, sizeof(payload_length));
+	memcpy(data + sizeof(ipc_magic) + sizeof(payload_length), &payload_type, sizeof(payload_type));
+	memcpy(data + IPC_HEADER_SIZE, payload, payload_length);
+	return message;
+}
+
+static void ipc_message_unref(struct ipc_message *message) {
+	if (--message->refs == 0) {
+		free(message);
+	}
+}
+
+static bool ipc_client_queue_message(struct ipc_client *client,
+		struct ipc_message *message) {
+	// A client that keeps up always gets its message, even a big one. Only a
+	// backlog of unread messages gets it disconnected.
+	size_t limit = config->ipc_backlog_limit;
+	if (client->write_queue_size > 0 &&
+			client->write_queue_size + message->size > limit) {
+		sway_log(SWAY_ERROR, "Client backlog too big (%zu), disconnecting client",
+				client->write_queue_size + message->size);
+		ipc_client_disconnect(client);
+		return false;
+	}
+
+	message->refs++;
+	list_add(client->write_queue, message);
+	client->write_queue_size += message->size;
+
+	if (!client->writable_event_source) {
+		client->writable_event_source = wl_event_loop_add_fd(
+				server.wl_event_loop, client->fd, WL_EVENT_WRITABLE,
+				ipc_client_handle_writable, client);
+	}
+
+	return true;
+}
+
 static void ipc_send_event(const char *json_string, enum ipc_command_type event) {
+	struct ipc_message *message = NULL;
 	struct ipc_client *client;
 	for (int i = 0; i < ipc_client_list->length; i++) {
 		client = ipc_client_list->items[i];
 		if ((client->subscribed_events & event_mask(event)) == 0) {
 			continue;
 		}
-		if (!ipc_send_reply(client, event, json_string,
-				(uint32_t)strlen(json_string))) {
-			sway_log_errno(SWAY_INFO, "Unable to send reply to IPC client");
-			/* ipc_send_reply destroys client on error, which also
-			 * removes it from the list, so we need to process
+		if (!message) {
+			message = ipc_message_create(event, json_string,
+				(uint32_t)strlen(json_string));
+			if (!message) {
+				return;
+			}
+		}
+		if (!ipc_client_queue_message(client, message)) {
+			sway_log(SWAY_INFO, "Unable to send event to IPC client");
+			/* ipc_client_queue_message destroys client on error, which
+			 * also removes it from the list, so we need to process
 			 * current index again */
 			i--;
 		}
 	}
+	if (message) {
+		ipc_message_unref(message);
+	}
 }
 
+static void ipc_event_state_schedule(bool workspaces, bool scroller,
+		bool trails);
+
 void ipc_event_workspace(struct sway_workspace *old,
 		struct sway_workspace *new, const char *change) {
+	// The focused workspace decides the scroller state
+	ipc_event_state_schedule(true, true, false);
 	if (!ipc_has_event_listeners(IPC_EVENT_WORKSPACE)) {
 		return;
 	}
@@ -523,6 +617,7 @@ void ipc_event_output(void) {
 }
 
 void ipc_event_scroller(const char *change, struct sway_workspace *workspace) {
+	ipc_event_state_schedule(false, true, false);
 	if (!ipc_has_event_listeners(IPC_EVENT_SCROLLER)) {
 		return;
 	}
@@ -538,6 +633,7 @@ void ipc_event_scroller(const char *change, struct sway_workspace *workspace) {
 }
 
 void ipc_event_trails() {
+	ipc_event_state_schedule(false, false, true);
 	if (!ipc_has_event_listeners(IPC_EVENT_TRAILS)) {
 		return;
 	}
@@ -551,6 +647,120 @@ void ipc_event_trails() {
 	json_object_put(json);
 }
 
+static void ipc_get_workspaces_callback(struct sway_workspace *workspace,
+		void *data);
+
+static void handle_state_idle(void *data) {
+	ipc_state.idle = NULL;
+	if (!ipc_has_event_listeners(IPC_EVENT_STATE)) {
+		ipc_state.workspaces = ipc_state.scroller = ipc_state.trails = false;
+		return;
+	}
+	sway_log(SWAY_DEBUG, "Sending state event");
+
+	json_object *json = json_object_new_object();
+	if (ipc_state.workspaces) {
+		json_object *workspaces = json_object_new_array();
+		root_for_each_workspace(ipc_get_workspaces_callback, workspaces);
+		json_object_object_add(json, "workspaces", workspaces);
+	}
+	if (ipc_state.scroller) {
+		struct sway_seat *seat = input_manager_get_default_seat();
+		struct sway_workspace *workspace = seat_get_focused_workspace(seat);
+		if (workspace) {
+			json_object_object_add(json, "scroller",
+				ipc_json_describe_scroller(workspace));
+		}
+	}
+	if (ipc_state.trails) {
+		json_object_object_add(json, "trails", ipc_json_describe_trails());
+	}
+	ipc_state.workspaces = ipc_state.scroller = ipc_state.trails = false;
+
+	const char *json_string = json_object_to_json_string(json);
+	ipc_send_event(json_string, IPC_EVENT_STATE);
+	json_object_put(json);
+}
+
+static void ipc_event_state_schedule(bool workspaces, bool scroller,
+		bool trails) {
+	if (!ipc_has_event_listeners(IPC_EVENT_STATE)) {
+		return;
+	}
+	ipc_state.workspaces |= workspaces;
+	ipc_state.scroller |= scroller;
+	ipc_state.trails |= trails;
+	if (!ipc_state.idle) {
+		ipc_state.idle = wl_event_loop_add_idle(server.wl_event_loop,
+			handle_state_idle, NULL);
+	}
+}
+
+static int handle_perf_timer(void *data) {
+	// Stop until somebody subscribes again
+	if (!ipc_has_event_listeners(IPC_EVENT_PERF)) {
+		return 0;
+	}
+	sway_log(SWAY_DEBUG, "Sending perf event");
+
+	json_object *json = ipc_json_describe_perf();
+	const char *json_string = json_object_to_json_string(json);
+	ipc_send_event(json_string, IPC_EVENT_PERF);
+	json_object_put(json);
+
+	wl_event_source_timer_update(ipc_perf_timer, IPC_PERF_EVENT_INTERVAL_MS);
+	return 0;
+}
+
+static void ipc_event_perf_schedule(void) {
+	if (!ipc_perf_timer) {
+		ipc_perf_timer = wl_event_loop_add_timer(server.wl_event_loop,
+			handle_perf_timer, NULL);
+		if (!ipc_perf_timer) {
+			sway_log_errno(SWAY_ERROR, "Unable to create perf event timer");
+			return;
+		}
+	}
+	wl_event_source_timer_update(ipc_perf_timer, IPC_PERF_EVENT_INTERVAL_MS);
+}
+
+// Changes of the transaction being applied, see ipc_event_tree_add()
+static json_object *tree_changes = NULL;
+static uint64_t tree_sequence = 0;
+
+bool ipc_event_tree_has_listeners(void) {
+	return ipc_has_event_listeners(IPC_EVENT_TREE);
+}
+
+void ipc_event_tree_add(struct sway_node *node, uint32_t changes) {
+	if (!tree_changes) {
+		tree_changes = json_object_new_array();
+	}
+	json_object_array_add(tree_changes,
+		ipc_json_describe_tree_change(node, changes));
+}
+
+void ipc_event_tree_send(void) {
+	if (!tree_changes) {
+		return;
+	}
+	json_object *changes = tree_changes;
+	tree_changes = NULL;
+	if (!ipc_has_event_listeners(IPC_EVENT_TREE)) {
+		json_object_put(changes);
+		return;
+	}
+	sway_log(SWAY_DEBUG, "Sending tree event");
+
+	json_object *json = json_object_new_object();
+	json_object_object_add(json, "sequence", json_object_new_int64(++tree_sequence));
+	json_object_object_add(json, "changes", changes);
+
+	const char *json_string = json_object_to_json_string(json);
+	ipc_send_event(json_string, IPC_EVENT_TREE);
+	json_object_put(json);
+}
+
 int ipc_client_handle_writable(int client_fd, uint32_t mask, void *data) {
 	struct ipc_client *client = data;
 
@@ -565,11 +775,23 @@ int ipc_client_handle_writable(int client_fd, uint32_t mask, void *data) {
 		return 0;
 	}
 
-	if (client->write_buffer_len <= 0) {
+	list_t *queue = client->write_queue;
+	if (queue->length == 0) {
 		return 0;
 	}
 
-	ssize_t written = write(client->fd, client->write_buffer, client->write_buffer_len);
+	struct iovec iov[IPC_WRITE_IOV_MAX];
+	int iovcnt = 0;
+	for (int i = 0; i < queue->length && iovcnt < IPC_WRITE_IOV_MAX; ++i) {
+		struct ipc_message *message = queue->items[i];
+		size_t offset = i == 0 ? client->write_offset : 0;
+		iov[iovcnt++] = (struct iovec){
+			.iov_base = message->data + offset,
+			.iov_len = message->size - offset,
+		};
+	}
+
+	ssize_t written = writev(client->fd, iov, iovcnt);
 
 	if (written == -1 && errno == EAGAIN) {
 		return 0;
@@ -579,10 +801,26 @@ int ipc_client_handle_writable(int client_fd, uint32_t mask, void *data) {
 		return 0;
 	}
 
-	memmove(client->write_buffer, client->write_buffer + written, client->write_buffer_len - written);
-	client->write_buffer_len -= written;
+	client->write_queue_size -= written;
+	size_t remaining = client->write_offset + written;
+	int done = 0;
+	while (done < queue->length) {
+		struct ipc_message *message = queue->items[done];
+		if (remaining < message->size) {
+			break;
+		}
+		remaining -= message->size;
+		ipc_message_unref(message);
+		done++;
+	}
+	client->write_offset = remaining;
+	if (done > 0) {
+		memmove(queue->items, queue->items + done,
+			(queue->length - done) * sizeof(*queue->items));
+		queue->length -= done;
+	}
 
-	if (client->write_buffer_len == 0 && client->writable_event_source) {
+	if (queue->length == 0 && client->writable_event_source) {
 		wl_event_source_remove(client->writable_event_source);
 		client->writable_event_source = NULL;
 	}
@@ -607,7 +845,10 @@ void ipc_client_disconnect(struct ipc_client *client) {
 		i++;
 	}
 	list_del(ipc_client_list, i);
-	free(client->write_buffer);
+	for (int j = 0; j < client->write_queue->length; ++j) {
+		ipc_message_unref(client->write_queue->items[j]);
+	}
+	list_free(client->write_queue);
 	close(client->fd);
 	free(client);
 }
@@ -769,6 +1010,7 @@ void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_lengt
 		}
 
 		bool is_tick = false;
+		bool is_perf = false;
 		// parse requested event types
 		for (size_t i = 0; i < json_object_array_length(request); i++) {
 			const char *event_type = json_object_get_string(json_object_array_get_idx(request, i));
@@ -797,6 +1039,13 @@ void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_lengt
 				client->subscribed_events |= event_mask(IPC_EVENT_SCROLLER);
 			} else if (strcmp(event_type, "trails") == 0) {
 				client->subscribed_events |= event_mask(IPC_EVENT_TRAILS);
+			} else if (strcmp(event_type, "tree") == 0) {
+				client->subscribed_events |= event_mask(IPC_EVENT_TREE);
+			} else if (strcmp(event_type, "perf") == 0) {
+				client->subscribed_events |= event_mask(IPC_EVENT_PERF);
+				is_perf = true;
+			} else if (strcmp(event_type, "state") == 0) {
+				client->subscribed_events |= event_mask(IPC_EVENT_STATE);
 			} else {
 				const char msg[] = "{\"success\": false}";
 				ipc_send_reply(client, payload_type, msg, strlen(msg));
@@ -814,6 +1063,9 @@ void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_lengt
 			ipc_send_reply(client, IPC_EVENT_TICK, tickmsg,
 				strlen(tickmsg));
 		}
+		if (is_perf) {
+			ipc_event_perf_schedule();
+		}
 		goto exit_cleanup;
 	}
 
@@ -981,6 +1233,16 @@ void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_lengt
 		goto exit_cleanup;
 	}
 
+	case IPC_GET_PERF:
+	{
+		json_object *json = ipc_json_describe_perf();
+		const char *json_string = json_object_to_json_string(json);
+		ipc_send_reply(client, payload_type, json_string,
+			(uint32_t)strlen(json_string));
+		json_object_put(json); // free
+		goto exit_cleanup;
+	}
+
 	default:
 		sway_log(SWAY_INFO, "Unknown IPC command type %x", payload_type);
 		goto exit_cleanup;
@@ -994,42 +1256,14 @@ bool ipc_send_reply(struct ipc_client *client, enum ipc_command_type payload_typ
 		const char *payload, uint32_t payload_length) {
 	assert(payload);
 
-	char data[IPC_HEADER_SIZE];
-
-	memcpy(data, ipc_magic, sizeof(ipc_magic));
-	memcpy(data + sizeof(ipc_magic), &payload_length, sizeof(payload_length));
-	memcpy(data + sizeof(ipc_magic) + sizeof(payload_length), &payload_type, sizeof(payload_type));
-
-	while (client->write_buffer_len + IPC_HEADER_SIZE + payload_length >=
-				 client->write_buffer_size) {
-		client->write_buffer_size *= 2;
-	}
-
-	if (client->write_buffer_size > 4e6) { // 4 MB
-		sway_log(SWAY_ERROR, "Client write buffer too big (%zu), disconnecting client",
-				client->write_buffer_size);
-		ipc_client_disconnect(client);
-		return false;
-	}
-
-	char *new_buffer = realloc(client->write_buffer, client->write_buffer_size);
-	if (!new_buffer) {
-		sway_log(SWAY_ERROR, "Unable to reallocate ipc client write buffer");
+	struct ipc_message *message =
+		ipc_message_create(payload_type, payload, payload_length);
+	if (!message) {
 		ipc_client_disconnect(client);
 		return false;
 	}
-	client->write_buffer = new_buffer;
 
-	memcpy(client->write_buffer + client->write_buffer_len, data, IPC_HEADER_SIZE);
-	client->write_buffer_len += IPC_HEADER_SIZE;
-	memcpy(client->write_buffer + client->write_buffer_len, payload, payload_length);
-	client->write_buffer_len += payload_length;
-
-	if (!client->writable_event_source) {
-		client->writable_event_source = wl_event_loop_add_fd(
-				server.wl_event_loop, client->fd, WL_EVENT_WRITABLE,
-				ipc_client_handle_writable, client);
-	}
-
-	return true;
+	bool queued = ipc_client_queue_message(client, message);
+	ipc_message_unref(message);
+	return queued;
 }
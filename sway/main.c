@@ -16,6 +16,7 @@
 #include <wlr/version.h>
 #include "sway/commands.h"
 #include "sway/config.h"
+#include "sway/perf.h"
 #include "sway/server.h"
 #include "sway/swaynag.h"
 #include "sway/desktop/transaction.h"
@@ -187,6 +188,8 @@ void enable_debug_flag(const char *flag) {
 		debug.txn_wait = true;
 	} else if (strcmp(flag, "txn-timings") == 0) {
 		debug.txn_timings = true;
+	} else if (strcmp(flag, "perf") == 0) {
+		debug.perf = true;
 	} else if (has_prefix(flag, "txn-timeout=")) {
 		server.txn_timeout_ms = atoi(&flag[strlen("txn-timeout=")]);
 	} else {
@@ -396,6 +399,7 @@ int main(int argc, char **argv) {
 
 shutdown:
 	sway_log(SWAY_INFO, "Shutting down sway");
+	perf_report();
 
 	server_fini(&server);
 	root_destroy(root);
@@ -403,6 +407,7 @@ shutdown:
 
 	free(config_path);
 	free_config(config);
+	perf_finish();
 
 	pango_cairo_font_map_set_default(NULL);
 
@@ -0,0 +1,166 @@
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sway/perf.h"
+#include "sway/server.h"
+#include "log.h"
+#include "util.h"
+
+struct sway_perf perf = {0};
+
+static const char *metric_names[PERF_METRIC_COUNT] = {
+	[PERF_FRAME_CPU] = "frame_cpu",
+	[PERF_TXN_LATENCY] = "transaction_latency",
+	[PERF_ANIMATION_STEP] = "animation_step",
+};
+
+const char *perf_metric_name(enum sway_perf_metric metric) {
+	return metric_names[metric];
+}
+
+// Values below 1 << PERF_HISTOGRAM_SUB_BITS get a bucket each, the rest are
+// bucketed by their exponent and the highest bits below it
+static int bucket_index(int64_t value) {
+	const int sub = 1 << PERF_HISTOGRAM_SUB_BITS;
+	if (value < sub) {
+		return value > 0 ? value : 0;
+	}
+	int exp = 63 - __builtin_clzll(value);
+	int mantissa = (value >> (exp - PERF_HISTOGRAM_SUB_BITS)) & (sub - 1);
+	return ((exp - PERF_HISTOGRAM_SUB_BITS + 1) << PERF_HISTOGRAM_SUB_BITS) | mantissa;
+}
+
+int64_t perf_histogram_bucket_bound(int index) {
+	const int sub = 1 << PERF_HISTOGRAM_SUB_BITS;
+	if (index < sub) {
+		return index;
+	}
+	int exp = (index >> PERF_HISTOGRAM_SUB_BITS) + PERF_HISTOGRAM_SUB_BITS - 1;
+	int64_t mantissa = sub + (index & (sub - 1));
+	return ((mantissa + 1) << (exp - PERF_HISTOGRAM_SUB_BITS)) - 1;
+}
+
+void perf_histogram_add(struct sway_perf_histogram *histogram, int64_t nsec) {
+	if (histogram->count == 0 || nsec < histogram->min) {
+		histogram->min = nsec;
+	}
+	if (histogram->count == 0 || nsec > histogram->max) {
+		histogram->max = nsec;
+	}
+	histogram->count++;
+	histogram->buckets[bucket_index(nsec)]++;
+}
+
+int64_t perf_histogram_percentile(const struct sway_perf_histogram *histogram,
+		double percentile) {
+	if (histogram->count == 0) {
+		return 0;
+	}
+	uint64_t rank = percentile / 100.0 * histogram->count;
+	if (rank >= histogram->count) {
+		rank = histogram->count - 1;
+	}
+	uint64_t seen = 0;
+	for (int i = 0; i < PERF_HISTOGRAM_BUCKETS; ++i) {
+		seen += histogram->buckets[i];
+		if (seen > rank) {
+			int64_t bound = perf_histogram_bucket_bound(i);
+			return bound < histogram->max ? bound : histogram->max;
+		}
+	}
+	return histogram->max;
+}
+
+void perf_record(enum sway_perf_metric metric, int64_t nsec) {
+	perf_histogram_add(&perf.histograms[metric], nsec);
+}
+
+void perf_record_since(enum sway_perf_metric metric, clockid_t clock,
+		const struct timespec *start) {
+	struct timespec now, elapsed;
+	clock_gettime(clock, &now);
+	timespec_sub(&elapsed, &now, start);
+	perf_record(metric, timespec_to_nsec(&elapsed));
+}
+
+static struct sway_perf_client *perf_client_get(const char *app_id) {
+	if (!perf.clients) {
+		perf.clients = create_list();
+	}
+	struct sway_perf_client *other = NULL;
+	for (int i = 0; i < perf.clients->length; ++i) {
+		struct sway_perf_client *client = perf.clients->items[i];
+		if (!client->app_id) {
+			other = client;
+		} else if (strcmp(client->app_id, app_id) == 0) {
+			return client;
+		}
+	}
+	if (perf.clients->length >= PERF_CLIENTS_MAX && other) {
+		return other;
+	}
+	struct sway_perf_client *client = calloc(1, sizeof(*client));
+	if (!client) {
+		return NULL;
+	}
+	// The last slot gathers everyone else
+	if (perf.clients->length < PERF_CLIENTS_MAX - 1) {
+		client->app_id = strdup(app_id);
+	}
+	list_add(perf.clients, client);
+	return client;
+}
+
+void perf_record_txn_slowest(const char *app_id, int64_t wait_nsec) {
+	struct sway_perf_client *client = perf_client_get(app_id ? app_id : "");
+	if (!client) {
+		return;
+	}
+	client->slowest++;
+	client->wait_total += wait_nsec;
+	if (wait_nsec > client->wait_max) {
+		client->wait_max = wait_nsec;
+	}
+}
+
+void perf_record_txn_timeout(const char *app_id) {
+	struct sway_perf_client *client = perf_client_get(app_id ? app_id : "");
+	if (client) {
+		client->timeouts++;
+	}
+}
+
+void perf_report(void) {
+	if (!debug.perf) {
+		return;
+	}
+	for (int i = 0; i < PERF_METRIC_COUNT; ++i) {
+		struct sway_perf_histogram *histogram = &perf.histograms[i];
+		if (histogram->count == 0) {
+			sway_log(SWAY_INFO, "perf: %s: no samples", metric_names[i]);
+			continue;
+		}
+		sway_log(SWAY_INFO, "perf: %s: %" PRIu64 " samples, "
+				"p50 %.3fms, p99 %.3fms, max %.3fms", metric_names[i],
+				histogram->count,
+				perf_histogram_percentile(histogram, 50.0) / 1000000.0,
+				perf_histogram_percentile(histogram, 99.0) / 1000000.0,
+				histogram->max / 1000000.0);
+	}
+	sway_log(SWAY_INFO, "perf: %" PRIu64 " transaction timeouts",
+		perf.txn_timeouts);
+}
+
+void perf_finish(void) {
+	if (!perf.clients) {
+		return;
+	}
+	for (int i = 0; i < perf.clients->length; ++i) {
+		struct sway_perf_client *client = perf.clients->items[i];
+		free(client->app_id);
+		free(client);
+	}
+	list_free(perf.clients);
+	perf.clients = NULL;
+}
@@ -1,7 +1,9 @@
 #include <drm_fourcc.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <wlr/types/wlr_buffer.h>
 #include <wlr/interfaces/wlr_buffer.h>
 #include "cairo_util.h"
@@ -9,6 +11,7 @@
 #include "pango.h"
 #include "sway/config.h"
 #include "sway/sway_text_node.h"
+#include "util.h"
 
 struct cairo_buffer {
 	struct wlr_buffer base;
@@ -65,26 +68,76 @@ static int get_text_width(struct sway_text_node *props) {
 	return MAX(width, 0);
 }
 
-static void render_backing_buffer(struct text_buffer *buffer) {
-	if (!buffer->visible) {
-		return;
-	}
+// Rendered text buffers are shared between all text nodes that show the same
+// string with the same properties. Title bars repeat a lot (same application,
+// unchanged title after a colour flip, the overview re-rendering everything),
+// so the most recently used ones are kept around.
+#define TEXT_CACHE_SIZE 128
+
+struct text_cache_key {
+	const char *text;
+	const char *font;
+	bool pango_markup;
+	float color[4];
+	float background[4];
+	int width, height;
+	int baseline;
+	int font_baseline;
+	float scale;
+	enum wl_output_subpixel subpixel;
+};
 
-	if (buffer->props.max_width == 0) {
-		sway_scene_buffer_set_buffer(buffer->buffer_node, NULL);
-		return;
+struct text_cache_entry {
+	struct wl_list link; // text_cache.entries, most recently used first
+	uint32_t hash;
+	struct text_cache_key key; // owns text and font
+	struct cairo_buffer *buffer;
+};
+
+static struct {
+	struct wl_list entries;
+	int length;
+	uint64_t hits, misses;
+} text_cache;
+
+static uint32_t text_cache_hash(const struct text_cache_key *key) {
+	// FNV-1a over the string, mixed with the size
+	uint32_t hash = 2166136261u;
+	for (const char *c = key->text; *c; ++c) {
+		hash = (hash ^ (uint8_t)*c) * 16777619u;
 	}
+	hash = (hash ^ (uint32_t)key->width) * 16777619u;
+	return (hash ^ (uint32_t)key->height) * 16777619u;
+}
 
-	float scale = buffer->scale * buffer->content_scale;
-	int width = ceil(get_text_width(&buffer->props) * scale);
-	int height = ceil(buffer->props.height * scale);
-	float *color = (float *)&buffer->props.color;
-	float *background = (float *)&buffer->props.background;
+static bool text_cache_key_equal(const struct text_cache_key *a,
+		const struct text_cache_key *b) {
+	return a->width == b->width && a->height == b->height &&
+		a->baseline == b->baseline && a->font_baseline == b->font_baseline &&
+		a->scale == b->scale && a->subpixel == b->subpixel &&
+		a->pango_markup == b->pango_markup &&
+		memcmp(a->color, b->color, sizeof(a->color)) == 0 &&
+		memcmp(a->background, b->background, sizeof(a->background)) == 0 &&
+		strcmp(a->text, b->text) == 0 && strcmp(a->font, b->font) == 0;
+}
+
+static void text_cache_entry_destroy(struct text_cache_entry *entry) {
+	wl_list_remove(&entry->link);
+	text_cache.length--;
+	// Text nodes still showing it keep their own lock
+	wlr_buffer_drop(&entry->buffer->base);
+	free((char *)entry->key.text);
+	free((char *)entry->key.font);
+	free(entry);
+}
+
+static struct cairo_buffer *render_text_buffer(const struct text_cache_key *key) {
+	struct cairo_buffer *cairo_buffer = NULL;
 	PangoContext *pango = NULL;
 
 	cairo_font_options_t *fo = cairo_font_options_create();
 	cairo_font_options_set_hint_style(fo, CAIRO_HINT_STYLE_FULL);
-	enum wl_output_subpixel subpixel = buffer->subpixel;
+	enum wl_output_subpixel subpixel = key->subpixel;
 	if (subpixel == WL_OUTPUT_SUBPIXEL_NONE || subpixel == WL_OUTPUT_SUBPIXEL_UNKNOWN) {
 		cairo_font_options_set_antialias(fo, CAIRO_ANTIALIAS_GRAY);
 	} else {
@@ -93,7 +146,7 @@ static void render_backing_buffer(struct text_buffer *buffer) {
 	}
 
 	cairo_surface_t *surface = cairo_image_surface_create(
-			CAIRO_FORMAT_ARGB32, width, height);
+			CAIRO_FORMAT_ARGB32, key->width, key->height);
 	cairo_status_t status = cairo_surface_status(surface);
 	if (status != CAIRO_STATUS_SUCCESS) {
 		sway_log(SWAY_ERROR, "cairo_image_surface_create failed: %s",
@@ -101,7 +154,7 @@ static void render_backing_buffer(struct text_buffer *buffer) {
 		goto err;
 	}
 
-	struct cairo_buffer *cairo_buffer = calloc(1, sizeof(*cairo_buffer));
+	cairo_buffer = calloc(1, sizeof(*cairo_buffer));
 	if (!cairo_buffer) {
 		sway_log(SWAY_ERROR, "cairo_buffer allocation failed");
 		goto err;
@@ -111,6 +164,7 @@ static void render_backing_buffer(struct text_buffer *buffer) {
 	if (!cairo) {
 		sway_log(SWAY_ERROR, "cairo_create failed");
 		free(cairo_buffer);
+		cairo_buffer = NULL;
 		goto err;
 	}
 
@@ -118,37 +172,129 @@ static void render_backing_buffer(struct text_buffer *buffer) {
 	cairo_set_font_options(cairo, fo);
 	pango = pango_cairo_create_context(cairo);
 
+	const float *color = key->color;
+	const float *background = key->background;
 	cairo_set_source_rgba(cairo, background[0], background[1], background[2], background[3]);
-	cairo_rectangle(cairo, 0, 0, width, height);
+	cairo_rectangle(cairo, 0, 0, key->width, key->height);
 	cairo_fill(cairo);
 
 	cairo_set_source_rgba(cairo, color[0], color[1], color[2], color[3]);
-	cairo_move_to(cairo, 0, (config->font_baseline - buffer->props.baseline) * scale);
+	cairo_move_to(cairo, 0, (key->font_baseline - key->baseline) * key->scale);
 
-	render_text(cairo, config->font_description, scale, buffer->props.pango_markup,
-		"%s", buffer->text);
+	render_text(cairo, config->font_description, key->scale, key->pango_markup,
+		"%s", key->text);
 
 	cairo_surface_flush(surface);
 
-	wlr_buffer_init(&cairo_buffer->base, &cairo_buffer_impl, width, height);
+	wlr_buffer_init(&cairo_buffer->base, &cairo_buffer_impl, key->width, key->height);
 	cairo_buffer->surface = surface;
 	cairo_buffer->cairo = cairo;
+	surface = NULL;
+
+err:
+	if (surface) cairo_surface_destroy(surface);
+	if (pango) g_object_unref(pango);
+	cairo_font_options_destroy(fo);
+	return cairo_buffer;
+}
 
-	sway_scene_buffer_set_buffer(buffer->buffer_node, &cairo_buffer->base);
-	wlr_buffer_drop(&cairo_buffer->base);
+static struct wlr_buffer *text_cache_get(const struct text_cache_key *key) {
+	if (!text_cache.entries.next) {
+		wl_list_init(&text_cache.entries);
+	}
+
+	uint32_t hash = text_cache_hash(key);
+	struct text_cache_entry *entry;
+	wl_list_for_each(entry, &text_cache.entries, link) {
+		if (entry->hash == hash && text_cache_key_equal(&entry->key, key)) {
+			text_cache.hits++;
+			wl_list_remove(&entry->link);
+			wl_list_insert(&text_cache.entries, &entry->link);
+			return &entry->buffer->base;
+		}
+	}
+
+	struct timespec start, end, duration;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	entry = calloc(1, sizeof(*entry));
+	if (!entry) {
+		sway_log(SWAY_ERROR, "text_cache_entry allocation failed");
+		return NULL;
+	}
+	entry->hash = hash;
+	entry->key = *key;
+	entry->key.text = strdup(key->text);
+	entry->key.font = strdup(key->font);
+	entry->buffer = render_text_buffer(key);
+	if (!entry->key.text || !entry->key.font || !entry->buffer) {
+		if (entry->buffer) {
+			wlr_buffer_drop(&entry->buffer->base);
+		}
+		free((char *)entry->key.text);
+		free((char *)entry->key.font);
+		free(entry);
+		return NULL;
+	}
+
+	wl_list_insert(&text_cache.entries, &entry->link);
+	text_cache.length++;
+	text_cache.misses++;
+	if (text_cache.length > TEXT_CACHE_SIZE) {
+		struct text_cache_entry *last =
+			wl_container_of(text_cache.entries.prev, last, link);
+		text_cache_entry_destroy(last);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	timespec_sub(&duration, &end, &start);
+	sway_log(SWAY_DEBUG, "Rendered %dx%d text in %.3f ms "
+		"(text cache: %d entries, %"PRIu64" hits, %"PRIu64" misses)",
+		key->width, key->height, timespec_to_nsec(&duration) / 1000000.0,
+		text_cache.length, text_cache.hits, text_cache.misses);
+
+	return &entry->buffer->base;
+}
+
+static void render_backing_buffer(struct text_buffer *buffer) {
+	if (!buffer->visible) {
+		return;
+	}
+
+	if (buffer->props.max_width == 0) {
+		sway_scene_buffer_set_buffer(buffer->buffer_node, NULL);
+		return;
+	}
+
+	float scale = buffer->scale * buffer->content_scale;
+	struct text_cache_key key = {
+		.text = buffer->text,
+		.font = config->font ? config->font : "",
+		.pango_markup = buffer->props.pango_markup,
+		.width = ceil(get_text_width(&buffer->props) * scale),
+		.height = ceil(buffer->props.height * scale),
+		.baseline = buffer->props.baseline,
+		.font_baseline = config->font_baseline,
+		.scale = scale,
+		.subpixel = buffer->subpixel,
+	};
+	memcpy(key.color, buffer->props.color, sizeof(key.color));
+	memcpy(key.background, buffer->props.background, sizeof(key.background));
+
+	struct wlr_buffer *wlr_buffer = text_cache_get(&key);
+	if (!wlr_buffer) {
+		return;
+	}
+	sway_scene_buffer_set_buffer(buffer->buffer_node, wlr_buffer);
 
 	pixman_region32_t opaque;
 	pixman_region32_init(&opaque);
-	if (background[3] == 1) {
+	if (buffer->props.background[3] == 1) {
 		pixman_region32_union_rect(&opaque, &opaque, 0, 0,
 			get_text_width(&buffer->props), buffer->props.height);
 	}
 	sway_scene_buffer_set_opaque_region(buffer->buffer_node, &opaque);
 	pixman_region32_fini(&opaque);
-
-err:
-	if (pango) g_object_unref(pango);
-	cairo_font_options_destroy(fo);
 }
 
 static void handle_outputs_update(struct wl_listener *listener, void *data) {
@@ -3,13 +3,17 @@
 #include "sway/tree/workspace.h"
 #include "sway/tree/arrange.h"
 #include "sway/sway_text_node.h"
+#include "sway/input/input-manager.h"
 #include "sway/input/seat.h"
+#include "sway/server.h"
 #include "util.h"
 #include <wayland-util.h>
 #include "sway/input/keyboard.h"
 #include "sway/desktop/transaction.h"
 #include "sway/input/cursor.h"
 #include "wlr/types/wlr_cursor.h"
+#include <wlr/render/wlr_texture.h>
+#include <wlr/types/wlr_buffer.h>
 #include "sway/ipc-server.h"
 
 enum wlr_direction layout_to_wlr_direction(enum sway_layout_direction dir) {
@@ -81,6 +85,53 @@ enum sway_container_layout layout_get_type(struct sway_workspace *workspace) {
 	return workspace->layout.type;
 }
 
+struct sway_container *layout_get_active_child(struct sway_node *parent) {
+	struct sway_seat *seat = input_manager_current_seat();
+	struct sway_node *node = seat_get_active_tiling_child(seat, parent);
+	return node && node != parent ? node->sway_container : NULL;
+}
+
+const double *layout_row_extents(enum sway_container_layout layout,
+		list_t *children, int gaps, double scale, bool current) {
+	static double *sums = NULL;
+	static int capacity = 0;
+	if (children->length + 1 > capacity) {
+		int new_capacity = capacity > 0 ? capacity : 16;
+		while (new_capacity < children->length + 1) {
+			new_capacity *= 2;
+		}
+		double *new_sums = realloc(sums, new_capacity * sizeof(double));
+		if (!new_sums) {
+			return NULL;
+		}
+		sums = new_sums;
+		capacity = new_capacity;
+	}
+	sums[0] = 0.0;
+	for (int i = 0; i < children->length; ++i) {
+		struct sway_container *con = children->items[i];
+		struct sway_container_state *state = current ? &con->current : &con->pending;
+		double extent = layout == L_HORIZ ? state->width : state->height;
+		sums[i + 1] = sums[i] + scale * (extent + 2.0 * gaps);
+	}
+	return sums;
+}
+
+// First index j in [lo, hi) with sums[j] > value (or >= if not strict), hi if
+// there is none. sums must be non-decreasing.
+static int row_extents_find(const double *sums, int lo, int hi, double value,
+		bool strict) {
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		if (strict ? sums[mid] > value : sums[mid] >= value) {
+			hi = mid;
+		} else {
+			lo = mid + 1;
+		}
+	}
+	return lo;
+}
+
 static void buffer_set_dest_size_iterator(struct sway_scene_buffer *buffer,
 		int sx, int sy, void *user_data) {
 	float *scale = user_data;
@@ -100,46 +151,61 @@ static void buffer_set_dest_size_iterator(struct sway_scene_buffer *buffer,
 	sway_scene_buffer_set_dest_size(buffer, round(width * *scale), round(height * *scale));
 }
 
-static void recreate_view_buffer(struct sway_container *view, float scale) {
+/**
+ * Whether the client's last committed size disagrees with the size we want
+ * from it. Views in a transaction are left alone, their configure is on
+ * its way.
+ */
+static bool view_out_of_sync(struct sway_container *con) {
+	struct sway_view *view = con->view;
+	return con->node.ntxnrefs == 0 &&
+		(view->geometry.width != con->pending.content_width ||
+		view->geometry.height != con->pending.content_height);
+}
+
+/**
+ * Scale the committed buffers of the view. When configure is false, as for
+ * the transient overview scale, only views whose contents are out of sync
+ * are reconfigured, so clients aren't asked to redraw at the same size.
+ */
+static void recreate_view_buffer(struct sway_container *view, float scale,
+		bool configure) {
 	float total_scale = scale;
 	if (view_is_content_scaled(view->view)) {
 		total_scale *= view_get_content_scale(view->view);
 	}
 	sway_scene_node_for_each_buffer(&view->content_tree->node,
 		buffer_set_dest_size_iterator, &total_scale);
-	// Views using CSD need to be reconfigured, otherwise the content
-	// is not in sync with our borders. Also, some views created while
-	// in scaled mode need to be reconfigured, so reconfigure everything
-	// just in case.
-	view_configure(view->view, view->pending.content_x, view->pending.content_y,
-		view->pending.content_width, view->pending.content_height);
-
+	// Only reconfigure when asked to, or when the committed geometry no
+	// longer matches the pending content size. Borders, including the
+	// ones around CSD views, are sized from the pending content size, so a
+	// view whose geometry already matches it is in sync and a configure
+	// would only make it redraw at the same size. Views that drifted, like
+	// some created while in scaled mode, are caught by view_out_of_sync();
+	// views with a transaction in flight get configured by it instead.
+	if (configure || view_out_of_sync(view)) {
+		view_configure(view->view, view->pending.content_x, view->pending.content_y,
+			view->pending.content_width, view->pending.content_height);
+	}
 }
 
-static void recreate_buffers(struct sway_workspace *workspace) {
+static void recreate_buffers(struct sway_workspace *workspace, bool configure) {
 	float scale = layout_scale_enabled(workspace) ? layout_scale_get(workspace) : 1.0f;
 	for (int i = 0; i < workspace->tiling->length; ++i) {
 		const struct sway_container *con = workspace->tiling->items[i];
 		for (int j = 0; j < con->pending.children->length; ++j) {
 			struct sway_container *view = con->pending.children->items[j];
-			recreate_view_buffer(view, scale);
+			recreate_view_buffer(view, scale, configure);
 		}
 	}
 	for (int i = 0; i < workspace->floating->length; ++i) {
-		const struct sway_container *con = workspace->floating->items[i];
+		struct sway_container *con = workspace->floating->items[i];
 		if (con->view) {
-			float total_scale = scale;
-			if (view_is_content_scaled(con->view)) {
-				total_scale *= view_get_content_scale(con->view);
-			}
-			sway_scene_node_for_each_buffer(&con->view->content_tree->node,
-				buffer_set_dest_size_iterator, &total_scale);
-			view_configure(con->view, con->pending.content_x, con->pending.content_y,
-				con->pending.content_width, con->pending.content_height);
+			recreate_view_buffer(con, scale, configure);
 		} else {
 			for (int j = 0; j < con->pending.children->length; ++j) {
 				struct sway_container *view = con->pending.children->items[j];
-				recreate_view_buffer(view, scale);
+				recreate_view_buffer(view, scale, configure);
 			}
 		}
 	}
@@ -157,15 +223,19 @@ void layout_overview_recompute_scale(struct sway_workspace *workspace, int gaps)
 	if (workspace->tiling->length == 0) {
 		return;
 	}
-	double w = gaps, maxh = -DBL_MAX;
+	const double *extents = layout_row_extents(L_HORIZ, workspace->tiling,
+		gaps, 1.0, false);
+	if (!extents) {
+		return;
+	}
+	double w = gaps + extents[workspace->tiling->length], maxh = -DBL_MAX;
 	for (int i = 0; i < workspace->tiling->length; ++i) {
 		const struct sway_container *con = workspace->tiling->items[i];
-		w += con->pending.width + 2 * gaps;
-		double h = gaps;
-		for (int j = 0; j < con->pending.children->length; ++j) {
-			const struct sway_container *view = con->pending.children->items[j];
-			h += view->pending.height + 2 * gaps;
+		extents = layout_row_extents(L_VERT, con->pending.children, gaps, 1.0, false);
+		if (!extents) {
+			return;
 		}
+		double h = gaps + extents[con->pending.children->length];
 		if (h > maxh) {
 			maxh = h;
 		}
@@ -174,7 +244,7 @@ void layout_overview_recompute_scale(struct sway_workspace *workspace, int gaps)
 	if (workspace->layers.tiling->node.scale != scale) {
 		workspace_set_scale(workspace, scale);
 		node_set_dirty(&workspace->node);
-		recreate_buffers(workspace);
+		recreate_buffers(workspace, false);
 	}
 }
 
@@ -184,7 +254,7 @@ void layout_overview_toggle(struct sway_workspace *workspace) {
 		workspace->layout.overview = false;
 		workspace_set_scale(workspace, workspace->layout.mem_scale);
 		node_set_dirty(&workspace->node);
-		recreate_buffers(workspace);
+		recreate_buffers(workspace, false);
 		if (workspace->layout.fullscreen) {
 			struct sway_seat *seat = input_manager_current_seat();
 			struct sway_container * focus = seat_get_focused_container(seat);
@@ -232,6 +302,18 @@ static void output_damage_whole(struct sway_output *output) {
 
 static const int workspaces_gap = 20;
 
+void layout_overview_workspaces_thumbnail_release(struct sway_workspace *workspace) {
+	if (workspace->layout.workspaces.thumbnail.texture) {
+		wlr_texture_destroy(workspace->layout.workspaces.thumbnail.texture);
+		workspace->layout.workspaces.thumbnail.texture = NULL;
+	}
+	if (workspace->layout.workspaces.thumbnail.buffer) {
+		wlr_buffer_drop(workspace->layout.workspaces.thumbnail.buffer);
+		workspace->layout.workspaces.thumbnail.buffer = NULL;
+	}
+	workspace->layout.workspaces.thumbnail.dirty = false;
+}
+
 void layout_overview_workspaces_toggle() {
 	root->overview = !root->overview;
 	for (int i = 0; i < root->outputs->length; i++) {
@@ -245,7 +327,7 @@ void layout_overview_workspaces_toggle() {
 			double uheight = round(usable_area->height * oscale);
 			int width = output->wlr_output->width;
 			int height = output->wlr_output->height;
-			const int length = output->current.workspaces->length;
+			const int length = output->workspaces->length;
 			const int rows = ceil(sqrt(length));
 			const double scale = fmin((uwidth - workspaces_gap * (rows + 1)) / (rows * width),
 				(uheight - workspaces_gap * (rows + 1)) / (rows * height));
@@ -261,13 +343,14 @@ void layout_overview_workspaces_toggle() {
 				double gapx = (uwidth - cols * scale * width) / (cols + 1);
 				double gapy = (uheight - rows * scale * height) / (rows + 1);
 				for (int c = 0; c < cols; ++c) {
-					struct sway_workspace *child = output->current.workspaces->items[j++];
+					struct sway_workspace *child = output->workspaces->items[j++];
 					child->layout.fullscreen = child->fullscreen;
 					child->layout.workspaces.x = round(left + gapx + c * (scale * width + gapx));
 					child->layout.workspaces.y = round(top + gapy + r * (scale * height + gapy));
 					child->layout.workspaces.width = ceil(scale * width);
 					child->layout.workspaces.height = ceil(scale * height);
 					child->layout.workspaces.scale = scale;
+					child->layout.workspaces.thumbnail.dirty = true;
 					child->layers.tiling->node.data = child;
 					node_set_dirty(&child->node);
 					if (child->fullscreen) {
@@ -281,9 +364,10 @@ void layout_overview_workspaces_toggle() {
 				}
 			}
 		} else {
-			for (int j = 0; j < output->current.workspaces->length; ++j) {
-				struct sway_workspace *child = output->current.workspaces->items[j];
+			for (int j = 0; j < output->workspaces->length; ++j) {
+				struct sway_workspace *child = output->workspaces->items[j];
 				child->layers.tiling->node.data = NULL;
+				layout_overview_workspaces_thumbnail_release(child);
 				node_set_dirty(&child->node);
 				if (child->layout.fullscreen) {
 					struct sway_seat *seat = input_manager_current_seat();
@@ -308,14 +392,14 @@ bool layout_overview_enabled(struct sway_workspace *workspace) {
 void layout_scale_set(struct sway_workspace *workspace, float scale) {
 	workspace_set_scale(workspace, scale);
 	node_set_dirty(&workspace->node);
-	recreate_buffers(workspace);
+	recreate_buffers(workspace, true);
 	ipc_event_scroller("scale", workspace);
 }
 
 void layout_scale_reset(struct sway_workspace *workspace) {
 	workspace_set_scale(workspace, -1.0f);
 	node_set_dirty(&workspace->node);
-	recreate_buffers(workspace);
+	recreate_buffers(workspace, true);
 	ipc_event_scroller("scale", workspace);
 }
 
@@ -444,14 +528,14 @@ static void position_new_container(struct sway_workspace *workspace,
 				double width = container->width_fraction * workspace->width;
 				container->pending.x = active->pending.x - width;
 			} else {
-				container->pending.x = active->pending.x + active->current.width;
+				container->pending.x = active->pending.x + active->pending.width;
 			}
 		} else {
 			if (container_idx < active_idx) {
 				double height = container->height_fraction * workspace->height;
 				container->pending.y = active->pending.y - height;
 			} else {
-				container->pending.y = active->pending.y + active->current.height;
+				container->pending.y = active->pending.y + active->pending.height;
 			}
 		}
 	}
@@ -576,7 +660,7 @@ void layout_move_container_to_workspace(struct sway_container *container, struct
 	// otherwise, we extract the view container and add it to the other workspace,
 	// inserting it in the active container (if any), or creating a new one
 	enum sway_container_layout mode = layout_modifiers_get_mode(old_ws);
-	struct sway_container *active = workspace->current.focused_inactive_child;
+	struct sway_container *active = layout_get_active_child(&workspace->node);
 	if (layout_get_type(old_ws) == mode) {
 		// Move the whole container
 		struct sway_container *con = container->view ? container->pending.parent : container;
@@ -621,7 +705,7 @@ static void drag_parent_container_to_workspace(struct sway_container *container,
 	}
 	// Find insertion point
 	enum sway_layout_insert pos = layout_modifiers_get_insert(workspace);
-	struct sway_container *active = workspace->current.focused_inactive_child;
+	struct sway_container *active = layout_get_active_child(&workspace->node);
 	layout_workspace_add_container(workspace, active, container, pos);
 }
 
@@ -1090,7 +1174,7 @@ static bool layout_move_container_nomode(struct sway_container *container, enum
 			list_del(parent->pending.children, 0);
 			// Insert container into neighbor
 			enum sway_layout_insert pos = layout_modifiers_get_insert(workspace);
-			struct sway_container *active = new_parent->current.focused_inactive_child;
+			struct sway_container *active = layout_get_active_child(&new_parent->node);
 			int new_index = layout_insert_compute_index(new_parent->pending.children, active, pos);
 			layout_insert_into_container(new_parent, container, new_index);
 			// Delete old parent container
@@ -1331,8 +1415,8 @@ void layout_jump() {
 
 	for (int i = 0; i < root->outputs->length; ++i) {
 		struct sway_output *output = root->outputs->items[i];
-		struct sway_workspace *workspace = output->current.active_workspace;
-		if (workspace->tiling->length > 0) {
+		struct sway_workspace *workspace = output_get_active_workspace(output);
+		if (workspace && workspace->tiling->length > 0) {
 			list_add(jump_data->workspaces, workspace);
 		}
 	}
@@ -1436,8 +1520,8 @@ static void jump_workspaces_handle_keyboard_key(struct sway_keyboard *keyboard,
 	u_int32_t n = 0;
 	for (int i = 0; i < root->outputs->length; ++i) {
 		struct sway_output *output = root->outputs->items[i];
-		for (int j = 0; j < output->current.workspaces->length; ++j) {
-			struct sway_workspace *child = output->current.workspaces->items[j];
+		for (int j = 0; j < output->workspaces->length; ++j) {
+			struct sway_workspace *child = output->workspaces->items[j];
 			if (focus && n == jump_data->window_number) {
 				switch_workspace(child);
 			}
@@ -1460,7 +1544,7 @@ void layout_jump_workspaces() {
 	uint32_t nworkspaces = 0;
 	for (int i = 0; i < root->outputs->length; ++i) {
 		struct sway_output *output = root->outputs->items[i];
-		nworkspaces += output->current.workspaces->length;
+		nworkspaces += output->workspaces->length;
 	}
 	if (nworkspaces == 0) {
 		free(jump_data);
@@ -1475,8 +1559,8 @@ void layout_jump_workspaces() {
 
 	for (int i = 0, n = 0; i < root->outputs->length; ++i) {
 		struct sway_output *output = root->outputs->items[i];
-		for (int j = 0; j < output->current.workspaces->length; ++j) {
-			struct sway_workspace *child = output->current.workspaces->items[j];
+		for (int j = 0; j < output->workspaces->length; ++j) {
+			struct sway_workspace *child = output->workspaces->items[j];
 			char *label = generate_label(n++, config->jump_labels_keys, nkeys);
 			workspace_toggle_jump_decoration(child, label);
 			free(label);
@@ -1648,48 +1732,29 @@ static struct sway_container *get_mouse_container(struct sway_seat *seat) {
 	struct sway_container *container = workspace->current.focused_inactive_child;
 	enum sway_container_layout layout = layout_get_type(workspace);
 	int active_idx = list_find(workspace->tiling, container);
+	if (active_idx < 0) {
+		return container;
+	}
+	const double *extents = layout_row_extents(layout, workspace->tiling,
+		workspace->gaps_inner, scale, false);
+	if (!extents) {
+		return container;
+	}
+	// Container i spans [origin + extents[i], origin + extents[i + 1]), with
+	// the origin taken from the active one
+	double cursor, origin;
 	if (layout == L_HORIZ) {
-		double offset = container->pending.x;
-		for (int i = active_idx; i < workspace->tiling->length; ++i) {
-			struct sway_container *con = workspace->tiling->items[i];
-			double x0 = offset - scale * workspace->gaps_inner;
-			double x1 = x0 + scale * (con->pending.width + 2.0 * workspace->gaps_inner);
-			if (seat->cursor->cursor->x >= x0 && seat->cursor->cursor->x < x1) {
-				return con;
-			}
-			offset = x1;
-		}
-		offset = container->pending.x;
-		for (int i = active_idx - 1; i >= 0; i--) {
-			struct sway_container *con = workspace->tiling->items[i];
-			double x1 = offset - scale * workspace->gaps_inner;
-			double x0 = x1 - scale * (con->pending.width + 2.0 * workspace->gaps_inner);
-			if (seat->cursor->cursor->x >= x0 && seat->cursor->cursor->x < x1) {
-				return con;
-			}
-			offset = x0;
-		}
+		cursor = seat->cursor->cursor->x;
+		origin = container->pending.x;
 	} else {
-		double offset = container->pending.y;
-		for (int i = active_idx; i < workspace->tiling->length; ++i) {
-			struct sway_container *con = workspace->tiling->items[i];
-			double y0 = offset - scale * workspace->gaps_inner;
-			double y1 = y0 + scale * (con->pending.height + 2.0 * workspace->gaps_inner);
-			if (seat->cursor->cursor->y >= y0 && seat->cursor->cursor->y < y1) {
-				return con;
-			}
-			offset = y1;
-		}
-		offset = container->pending.y;
-		for (int i = active_idx - 1; i >= 0; i--) {
-			struct sway_container *con = workspace->tiling->items[i];
-			double y1 = offset - scale * workspace->gaps_inner;
-			double y0 = y1 - scale * (con->pending.height + 2.0 * workspace->gaps_inner);
-			if (seat->cursor->cursor->y >= y0 && seat->cursor->cursor->y < y1) {
-				return con;
-			}
-			offset = y0;
-		}
+		cursor = seat->cursor->cursor->y;
+		origin = container->pending.y;
+	}
+	origin -= scale * workspace->gaps_inner + extents[active_idx];
+	int i = row_extents_find(extents, 0, workspace->tiling->length + 1,
+		cursor - origin, true) - 1;
+	if (i >= 0 && i < workspace->tiling->length) {
+		return workspace->tiling->items[i];
 	}
 	return container;
 }
@@ -1707,7 +1772,6 @@ static void scroll_workspace(struct sway_workspace *workspace, double dx, double
 		}
 	}
 	node_set_dirty(&workspace->node);
-	transaction_commit_dirty();
 }
 
 static void scroll_container(struct sway_container *container, double dx, double dy) {
@@ -1727,7 +1791,55 @@ static void scroll_container(struct sway_container *container, double dx, double
 		}
 	}
 	node_set_dirty(&container->node);
-	transaction_commit_dirty();
+}
+
+// Apply the accumulated scrolling deltas. Returns true if anything moved.
+static bool scroll_flush(struct sway_workspace *workspace) {
+	if (!workspace->gesture.pending) {
+		return false;
+	}
+	workspace->gesture.pending = false;
+	if (workspace->gesture.ws_dx != 0.0 || workspace->gesture.ws_dy != 0.0) {
+		scroll_workspace(workspace, workspace->gesture.ws_dx,
+			workspace->gesture.ws_dy);
+	}
+	struct sway_container *container = workspace->gesture.container;
+	// The column may have gone away since the deltas were queued
+	if (container && list_find(workspace->tiling, container) >= 0 &&
+			(workspace->gesture.con_dx != 0.0 || workspace->gesture.con_dy != 0.0)) {
+		scroll_container(container, workspace->gesture.con_dx,
+			workspace->gesture.con_dy);
+	}
+	workspace->gesture.ws_dx = workspace->gesture.ws_dy = 0.0;
+	workspace->gesture.con_dx = workspace->gesture.con_dy = 0.0;
+	return true;
+}
+
+// Queue scrolling deltas to be applied at the next frame of the workspace
+// output, so high rate input devices don't commit a transaction per event.
+static void scroll_queue(struct sway_workspace *workspace,
+		struct sway_container *container, double dx, double dy) {
+	if (container) {
+		if (workspace->gesture.container != container &&
+				(workspace->gesture.con_dx != 0.0 || workspace->gesture.con_dy != 0.0)) {
+			// A different column: apply what we have for the previous one
+			scroll_flush(workspace);
+			transaction_commit_dirty();
+		}
+		workspace->gesture.container = container;
+		workspace->gesture.con_dx += dx;
+		workspace->gesture.con_dy += dy;
+	} else {
+		workspace->gesture.ws_dx += dx;
+		workspace->gesture.ws_dy += dy;
+	}
+	workspace->gesture.pending = true;
+	if (workspace->output && workspace->output->enabled) {
+		wlr_output_schedule_frame(workspace->output->wlr_output);
+	} else {
+		scroll_flush(workspace);
+		transaction_commit_dirty();
+	}
 }
 
 static void layout_scroll_float_pinned_container(struct sway_workspace *workspace) {
@@ -1852,18 +1964,30 @@ static void layout_scroll_unfloat_pinned_container(struct sway_workspace *worksp
 // Gestures
 bool layout_scroll_begin(struct sway_seat *seat) {
 	struct sway_workspace *workspace = seat->workspace;
+	if (workspace->gesture.momentum) {
+		// Catch the layout while it glides, and carry on with the same gesture
+		workspace->gesture.momentum = false;
+		workspace->gesture.vx = workspace->gesture.vy = 0.0;
+		workspace->gesture.seat = seat;
+		clock_gettime(CLOCK_MONOTONIC, &workspace->gesture.last);
+		return true;
+	}
 	// Check if we can scroll
 	float scale = layout_scale_enabled(workspace) ? layout_scale_get(workspace) : 1.0f;
-	double total_width = 0.0, max_height = 0.0;
 	const int gap = workspace->gaps_inner;
+	const double *extents = layout_row_extents(L_HORIZ, workspace->tiling,
+		gap, scale, false);
+	if (!extents) {
+		return false;
+	}
+	double total_width = extents[workspace->tiling->length], max_height = 0.0;
 	for (int i = 0; i < workspace->tiling->length; ++i) {
 		struct sway_container *con = workspace->tiling->items[i];
-		total_width += scale * (con->pending.width + 2.0 * gap);
-		double total_height = 0.0;
-		for (int j = 0; j < con->pending.children->length; ++j) {
-			struct sway_container *child = con->pending.children->items[j];
-			total_height += scale * (child->pending.height + 2.0 * gap);
+		extents = layout_row_extents(L_VERT, con->pending.children, gap, scale, false);
+		if (!extents) {
+			return false;
 		}
+		double total_height = extents[con->pending.children->length];
 		if (total_height > max_height) {
 			max_height = total_height;
 		}
@@ -1877,6 +2001,9 @@ bool layout_scroll_begin(struct sway_seat *seat) {
 	workspace->gesture.scrolling = true;
 	workspace->gesture.dx = 0.0;
 	workspace->gesture.dy = 0.0;
+	workspace->gesture.seat = seat;
+	workspace->gesture.vx = workspace->gesture.vy = 0.0;
+	clock_gettime(CLOCK_MONOTONIC, &workspace->gesture.last);
 
 	// If there is a pinned container, float it.
 	struct sway_container *pin = layout_pin_enabled(workspace) ? layout_pin_get_container(workspace) : NULL;
@@ -1910,97 +2037,91 @@ void layout_scroll_update(struct sway_seat *seat, double dx, double dy) {
 		workspace->gesture.dy += dy;
 	}
 
+	struct sway_container *container = NULL;
 	switch (scrolling_direction) {
 	case DIR_UP:
 	case DIR_DOWN:
 		if (layout_get_type(workspace) == L_HORIZ) {
-			scroll_container(get_mouse_container(seat), dx, dy);
-		} else {
-			scroll_workspace(workspace, dx, dy);
+			container = get_mouse_container(seat);
 		}
 		break;
 	case DIR_LEFT:
 	case DIR_RIGHT:
-		if (layout_get_type(workspace) == L_HORIZ) {
-			scroll_workspace(workspace, dx, dy);
-		} else {
-			scroll_container(get_mouse_container(seat), dx, dy);
+		if (layout_get_type(workspace) == L_VERT) {
+			container = get_mouse_container(seat);
 		}
 		break;
 	default:
 		break;
 	}
+	scroll_queue(workspace, container, dx, dy);
+
+	// Track the release velocity for kinetic scrolling, smoothing out the
+	// jitter of individual events
+	struct timespec now, elapsed;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	timespec_sub(&elapsed, &now, &workspace->gesture.last);
+	workspace->gesture.last = now;
+	double dt = fmax(timespec_to_nsec(&elapsed) / 1e9, 0.001);
+	if (workspace->gesture.momentum_container != (container != NULL) || dt > 0.1) {
+		workspace->gesture.vx = workspace->gesture.vy = 0.0;
+	}
+	workspace->gesture.momentum_container = container != NULL;
+	workspace->gesture.vx = 0.6 * workspace->gesture.vx + 0.4 * dx / dt;
+	workspace->gesture.vy = 0.6 * workspace->gesture.vy + 0.4 * dy / dt;
 }
 
-static void scroll_end_horizontal(struct sway_seat *seat, list_t *children, int active_idx,
-		enum sway_layout_direction scrolling_direction) {
+// Picks the new active container of a row after a scroll gesture: the first
+// one past the active, in the scrolling direction, that has its leading edge in
+// the viewport, or the last one in that direction if none does.
+static void scroll_end_row(struct sway_seat *seat, list_t *children, int active_idx,
+		enum sway_container_layout layout, bool forward) {
 	struct sway_container *active = children->items[active_idx];
 	struct sway_workspace *workspace = active->pending.workspace;
 	float scale = layout_scale_enabled(workspace) ? layout_scale_get(workspace) : 1.0f;
-	if (scrolling_direction == DIR_LEFT) {
+	const double *extents = layout_row_extents(layout, children,
+		workspace->gaps_inner, scale, false);
+	if (!extents) {
+		return;
+	}
+	double position = layout == L_HORIZ ? active->pending.x : active->pending.y;
+	double size = layout == L_HORIZ ? workspace->width : workspace->height;
+	// Edges only grow with the index, so the viewport test is a binary search
+	if (forward) {
 		struct sway_container *new_active = children->items[children->length - 1];
-		double offset = active->pending.x + scale * (active->pending.width + 2.0 * workspace->gaps_inner);
-		// Take the first after active that has its left edge in the viewport
-		for (int i = active_idx + 1; i < children->length; ++i) {
-			struct sway_container *con = children->items[i];
-			double x0 = offset;
-			if (x0 > 0 && x0 < workspace->width) {
-				new_active = con;
-				break;
-			}
-			offset += scale * (con->pending.width + 2.0 * workspace->gaps_inner);
+		// Leading edge of container i is position + extents[i] - extents[active_idx]
+		double base = position - extents[active_idx];
+		int i = row_extents_find(extents, active_idx + 1, children->length,
+			-base, true);
+		if (i < children->length && base + extents[i] < size) {
+			new_active = children->items[i];
 		}
 		seat_set_focus_container(seat, new_active);
-    } else if (scrolling_direction == DIR_RIGHT) {
+	} else {
 		struct sway_container *new_active = children->items[0];
-		double offset = active->pending.x - 2.0 * scale * workspace->gaps_inner;
-		// Take the first before active that has its right edge in the viewport
-		for (int i = active_idx - 1; i >= 0; i--) {
-			struct sway_container *con = children->items[i];
-			double x1 = offset;
-			if (x1 > 0 && x1 < workspace->width) {
-				new_active = con;
-				break;
-			}
-			offset -= scale * (con->pending.width + 2.0 * workspace->gaps_inner);
+		// Trailing edge of container i is base + extents[i + 1]
+		double base = position - 2.0 * scale * workspace->gaps_inner - extents[active_idx];
+		int k = row_extents_find(extents, 1, active_idx + 1, size - base, false) - 1;
+		if (k >= 1 && base + extents[k] > 0) {
+			new_active = children->items[k - 1];
 		}
 		seat_set_focus_container(seat, new_active);
 	}
 }
 
+static void scroll_end_horizontal(struct sway_seat *seat, list_t *children, int active_idx,
+		enum sway_layout_direction scrolling_direction) {
+	if (scrolling_direction == DIR_LEFT || scrolling_direction == DIR_RIGHT) {
+		scroll_end_row(seat, children, active_idx, L_HORIZ,
+			scrolling_direction == DIR_LEFT);
+	}
+}
+
 static void scroll_end_vertical(struct sway_seat *seat, list_t *children, int active_idx,
 		enum sway_layout_direction scrolling_direction) {
-	struct sway_container *active = children->items[active_idx];
-	struct sway_workspace *workspace = active->pending.workspace;
-	float scale = layout_scale_enabled(workspace) ? layout_scale_get(workspace) : 1.0f;
-	if (scrolling_direction == DIR_UP) {
-		struct sway_container *new_active = children->items[children->length - 1];
-		double offset = active->pending.y + scale * (active->pending.height + 2.0 * workspace->gaps_inner);
-		// Take the first after active that has its top edge in the viewport
-		for (int i = active_idx + 1; i < children->length; ++i) {
-			struct sway_container *con = children->items[i];
-			double y0 = offset;
-			if (y0 > 0 && y0 < workspace->height) {
-				new_active = con;
-				break;
-			}
-			offset += scale * (con->pending.height + 2.0 * workspace->gaps_inner);
-		}
-		seat_set_focus_container(seat, new_active);
-    } else if (scrolling_direction == DIR_DOWN) {
-		struct sway_container *new_active = children->items[0];
-		double offset = active->pending.y - 2.0 * scale * workspace->gaps_inner;
-		// Take the first before active that has its bottom edge in the viewport
-		for (int i = active_idx - 1; i >= 0; i--) {
-			struct sway_container *con = children->items[i];
-			double y1 = offset;
-			if (y1 > 0 && y1 < workspace->height) {
-				new_active = con;
-				break;
-			}
-			offset -= scale * (con->pending.height + 2.0 * workspace->gaps_inner);
-		}
-		seat_set_focus_container(seat, new_active);
+	if (scrolling_direction == DIR_UP || scrolling_direction == DIR_DOWN) {
+		scroll_end_row(seat, children, active_idx, L_VERT,
+			scrolling_direction == DIR_UP);
 	}
 }
 
@@ -2013,12 +2134,114 @@ static bool scrolling_in_pin_direction(enum sway_container_layout layout,
 	return false;
 }
 
+// Below this speed (layout pixels per second) kinetic scrolling stops
+static const double scroll_momentum_min_speed = 30.0;
+
+static void scroll_finish(struct sway_seat *seat, struct sway_workspace *workspace);
+
 bool layout_scroll_end(struct sway_seat *seat) {
 	struct sway_workspace *workspace = seat->workspace;
 	if (!workspace->gesture.scrolling) {
 		return false;
 	}
+	if (scroll_flush(workspace)) {
+		transaction_commit_dirty();
+	}
+
+	// A pause before lifting the fingers means there is no fling
+	struct timespec now, elapsed;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	timespec_sub(&elapsed, &now, &workspace->gesture.last);
+	if (config->gesture_scroll_friction > 0.0f && workspace->output &&
+			workspace->output->enabled &&
+			timespec_to_nsec(&elapsed) < 100000000 &&
+			hypot(workspace->gesture.vx, workspace->gesture.vy) >
+			scroll_momentum_min_speed) {
+		workspace->gesture.momentum = true;
+		workspace->gesture.seat = seat;
+		workspace->gesture.last = now;
+		wlr_output_schedule_frame(workspace->output->wlr_output);
+		return true;
+	}
+
+	scroll_finish(seat, workspace);
+	return true;
+}
+
+static void scroll_momentum_step(struct sway_workspace *workspace,
+		const struct timespec *when) {
+	struct timespec elapsed;
+	timespec_sub(&elapsed, when, &workspace->gesture.last);
+	double dt = timespec_to_nsec(&elapsed) / 1e9;
+	if (dt <= 0.0) {
+		return;
+	}
+	workspace->gesture.last = *when;
+	dt = fmin(dt, 0.1);
+
+	// Exponential decay of the velocity, integrated exactly over the step
+	double friction = config->gesture_scroll_friction;
+	double decay = exp(-friction * dt);
+	double dx = workspace->gesture.vx * (1.0 - decay) / friction;
+	double dy = workspace->gesture.vy * (1.0 - decay) / friction;
+	workspace->gesture.vx *= decay;
+	workspace->gesture.vy *= decay;
+	workspace->gesture.dx += dx;
+	workspace->gesture.dy += dy;
+
+	struct sway_container *container = NULL;
+	if (workspace->gesture.momentum_container) {
+		container = workspace->gesture.container;
+		if (!container || list_find(workspace->tiling, container) < 0) {
+			workspace->gesture.vx = workspace->gesture.vy = 0.0;
+			return;
+		}
+		workspace->gesture.con_dx += dx;
+		workspace->gesture.con_dy += dy;
+	} else {
+		workspace->gesture.ws_dx += dx;
+		workspace->gesture.ws_dy += dy;
+	}
+	workspace->gesture.pending = true;
+}
 
+// The seat that started a glide may be destroyed before the glide ends
+static struct sway_seat *scroll_momentum_seat(struct sway_workspace *workspace) {
+	struct sway_seat *seat;
+	wl_list_for_each(seat, &server.input->seats, link) {
+		if (seat == workspace->gesture.seat) {
+			return seat;
+		}
+	}
+	workspace->gesture.seat = input_manager_current_seat();
+	return workspace->gesture.seat;
+}
+
+bool layout_scroll_frame(struct sway_output *output, const struct timespec *when) {
+	bool dirty = false, running = false;
+	for (int i = 0; i < output->workspaces->length; ++i) {
+		struct sway_workspace *workspace = output->workspaces->items[i];
+		if (workspace->gesture.momentum) {
+			scroll_momentum_step(workspace, when);
+			if (hypot(workspace->gesture.vx, workspace->gesture.vy) <=
+					scroll_momentum_min_speed) {
+				// The glide is over: snap to a window like a regular release
+				workspace->gesture.momentum = false;
+				scroll_flush(workspace);
+				scroll_finish(scroll_momentum_seat(workspace), workspace);
+				continue;
+			}
+			running = true;
+		}
+		dirty |= scroll_flush(workspace);
+	}
+	if (dirty) {
+		transaction_commit_dirty();
+	}
+	return running;
+}
+
+static void scroll_finish(struct sway_seat *seat, struct sway_workspace *workspace) {
 	enum sway_layout_direction scrolling_direction;
 	enum sway_container_layout layout = layout_get_type(workspace);
 	if (fabs(workspace->gesture.dx) > fabs(workspace->gesture.dy)) {
@@ -2030,13 +2253,13 @@ bool layout_scroll_end(struct sway_seat *seat) {
 	if (workspace->gesture.pin) {
 		layout_scroll_unfloat_pinned_container(workspace);
 		if (scrolling_in_pin_direction(layout, scrolling_direction)) {
-			return true;
+			return;
 		}
 	}
 
 	workspace->gesture.scrolling = false;
 	if (workspace->tiling->length == 0) {
-		return true;
+		return;
 	}
 	if (scrolling_direction == DIR_LEFT || scrolling_direction == DIR_RIGHT) {
 		if (layout == L_HORIZ) {
@@ -2063,7 +2286,6 @@ bool layout_scroll_end(struct sway_seat *seat) {
 	}
 	arrange_workspace(workspace);
 	transaction_commit_dirty();
-	return true;
 }
 
 bool layout_pin_enabled(struct sway_workspace *workspace) {
@@ -2148,9 +2370,9 @@ void layout_selection_workspace(struct sway_workspace *workspace) {
 void layout_selection_reset() {
 	for (int o = 0; o < root->outputs->length; ++o) {
 		struct sway_output *output = root->outputs->items[o];
-		for (int w = 0; w < output->current.workspaces->length; ++w) {
+		for (int w = 0; w < output->workspaces->length; ++w) {
 			bool selected = false;
-			struct sway_workspace *workspace = output->current.workspaces->items[w];
+			struct sway_workspace *workspace = output->workspaces->items[w];
 			for (int i = 0; i < workspace->floating->length; ++i) {
 				struct sway_container *con = workspace->floating->items[i];
 				if (con->selected) {
@@ -2272,9 +2494,9 @@ bool layout_selection_move(struct sway_workspace *new_workspace) {
 	list_t *floating_selection = create_list();
 	for (int o = 0; o < root->outputs->length; ++o) {
 		struct sway_output *output = root->outputs->items[o];
-		for (int w = 0; w < output->current.workspaces->length; ++w) {
+		for (int w = 0; w < output->workspaces->length; ++w) {
 			int selected = tiling_selection->length + floating_selection->length;
-			struct sway_workspace *workspace = output->current.workspaces->items[w];
+			struct sway_workspace *workspace = output->workspaces->items[w];
 			list_t *to_delete_floating = create_list();
 			for (int i = 0; i < workspace->floating->length; ++i) {
 				struct sway_container *con = workspace->floating->items[i];
@@ -2329,7 +2551,7 @@ bool layout_selection_move(struct sway_workspace *new_workspace) {
 	}
 	bool changed = tiling_selection->length + floating_selection->length > 0;
 	// Insert tiled containers
-	struct sway_container *active = new_workspace->current.focused_inactive_child;
+	struct sway_container *active = layout_get_active_child(&new_workspace->node);
 	int index = layout_insert_compute_index(new_workspace->tiling, active, layout_modifiers_get_insert(new_workspace));
 	for (int i = tiling_selection->length - 1; i >= 0; i--) {
 		struct sway_container *con = tiling_selection->items[i];
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <wlr/backend.h>
+#include <wlr/render/allocator.h>
 #include <wlr/render/swapchain.h>
 #include <wlr/render/drm_syncobj.h>
 #include <wlr/render/wlr_renderer.h>
@@ -12,6 +13,7 @@
 #include <wlr/types/wlr_presentation_time.h>
 #include <wlr/util/region.h>
 #include <wlr/util/transform.h>
+#include "list.h"
 #include "util.h"
 #include "log.h"
 #include "sway/tree/scene.h"
@@ -116,6 +118,11 @@ static void scene_buffer_set_buffer(struct sway_scene_buffer *scene_buffer,
 	struct wlr_buffer *buffer);
 static void scene_buffer_set_texture(struct sway_scene_buffer *scene_buffer,
 	struct wlr_texture *texture);
+static bool scene_buffer_is_black_opaque(struct sway_scene_buffer *scene_buffer);
+
+static void scene_invalidate_render_lists(struct sway_scene *scene) {
+	scene->render_list_serial++;
+}
 
 void sway_scene_node_destroy(struct sway_scene_node *node) {
 	if (node == NULL) {
@@ -131,6 +138,7 @@ void sway_scene_node_destroy(struct sway_scene_node *node) {
 	sway_scene_node_set_enabled(node, false);
 
 	struct sway_scene *scene = scene_node_get_root(node);
+	scene_invalidate_render_lists(scene);
 	if (node->type == SWAY_SCENE_NODE_BUFFER) {
 		struct sway_scene_buffer *scene_buffer = sway_scene_buffer_from_node(node);
 
@@ -349,6 +357,8 @@ struct render_data {
 	int trans_width, trans_height;
 
 	struct sway_scene_output *output;
+	// Set when rendering into the overview thumbnail of this workspace
+	struct sway_workspace *thumbnail;
 
 	struct wlr_render_pass *render_pass;
 	pixman_region32_t damage;
@@ -414,7 +424,41 @@ static void scene_output_damage_whole(struct sway_scene_output *scene_output) {
 	pixman_region32_fini(&damage);
 }
 
-static void scene_damage_outputs(struct sway_scene *scene, pixman_region32_t *damage) {
+// In the workspaces overview, damage on a node of a workspace only touches
+// that workspace's thumbnail, and marks the thumbnail for redraw
+static void scene_output_damage_workspace(struct sway_scene_output *scene_output,
+		struct sway_workspace *workspace, const pixman_region32_t *damage) {
+	if (!workspace) {
+		scene_output_damage(scene_output, damage);
+		return;
+	}
+	if (!workspace->output || workspace->output->scene_output != scene_output) {
+		return;
+	}
+
+	struct wlr_output *output = scene_output->output;
+	pixman_region32_t thumbnail_damage;
+	pixman_region32_init(&thumbnail_damage);
+	pixman_region32_intersect_rect(&thumbnail_damage, damage, 0, 0,
+		output->width, output->height);
+
+	if (!pixman_region32_empty(&thumbnail_damage)) {
+		workspace->layout.workspaces.thumbnail.dirty = true;
+
+		int x = workspace->layout.workspaces.x;
+		int y = workspace->layout.workspaces.y;
+		scale_region(&thumbnail_damage, workspace->layout.workspaces.scale, true);
+		pixman_region32_translate(&thumbnail_damage, x, y);
+		pixman_region32_intersect_rect(&thumbnail_damage, &thumbnail_damage, x, y,
+			workspace->layout.workspaces.width, workspace->layout.workspaces.height);
+		scene_output_damage(scene_output, &thumbnail_damage);
+	}
+
+	pixman_region32_fini(&thumbnail_damage);
+}
+
+static void scene_damage_outputs(struct sway_scene *scene,
+		struct sway_workspace *workspace, pixman_region32_t *damage) {
 	if (pixman_region32_empty(damage)) {
 		return;
 	}
@@ -428,7 +472,7 @@ static void scene_damage_outputs(struct sway_scene *scene, pixman_region32_t *da
 			-scene_output->x, -scene_output->y);
 		scale_region(&output_damage, scene_output->output->scale, true);
 		output_to_buffer_coords(&output_damage, scene_output->output);
-		scene_output_damage(scene_output, &output_damage);
+		scene_output_damage_workspace(scene_output, workspace, &output_damage);
 		pixman_region32_fini(&output_damage);
 	}
 }
@@ -638,6 +682,16 @@ static struct sway_workspace *scene_node_get_workspace(struct sway_scene_node *n
 	return NULL;
 }
 
+// Workspace thumbnail a node damages, only set in the workspaces overview.
+// Checked first so node and buffer updates skip the ancestor walk otherwise.
+static struct sway_workspace *scene_node_get_overview_workspace(
+		struct sway_scene_node *node) {
+	if (!layout_overview_workspaces_enabled()) {
+		return NULL;
+	}
+	return scene_node_get_workspace(node);
+}
+
 static void scene_node_apply_tiling_visibility(struct sway_scene_node *node,
 		struct wl_list *outputs) {
 	struct wlr_output *wlr_output = scene_node_get_output(node);
@@ -731,6 +785,8 @@ static void scene_node_bounds(struct sway_scene_node *node,
 
 static void scene_update_region(struct sway_scene *scene,
 		pixman_region32_t *update_region) {
+	scene_invalidate_render_lists(scene);
+
 	pixman_region32_t visible;
 	pixman_region32_init(&visible);
 	pixman_region32_copy(&visible, update_region);
@@ -758,6 +814,8 @@ static void scene_update_region(struct sway_scene *scene,
 static void scene_node_update(struct sway_scene_node *node,
 		pixman_region32_t *damage) {
 	struct sway_scene *scene = scene_node_get_root(node);
+	struct sway_workspace *workspace = scene_node_get_overview_workspace(node);
+	scene_invalidate_render_lists(scene);
 
 	int x, y;
 	if (!sway_scene_node_coords(node, &x, &y)) {
@@ -766,7 +824,7 @@ static void scene_node_update(struct sway_scene_node *node,
 #endif
 		if (damage) {
 			scene_update_region(scene, damage);
-			scene_damage_outputs(scene, damage);
+			scene_damage_outputs(scene, workspace, damage);
 			pixman_region32_fini(damage);
 		}
 
@@ -789,7 +847,7 @@ static void scene_node_update(struct sway_scene_node *node,
 	pixman_region32_fini(&update_region);
 
 	scene_node_visibility(node, damage);
-	scene_damage_outputs(scene, damage);
+	scene_damage_outputs(scene, workspace, damage);
 	pixman_region32_fini(damage);
 }
 
@@ -842,6 +900,9 @@ static void scene_buffer_handle_buffer_release(struct wl_listener *listener,
 	scene_buffer->buffer = NULL;
 	wl_list_remove(&scene_buffer->buffer_release.link);
 	wl_list_init(&scene_buffer->buffer_release.link);
+
+	// Without a buffer nor a texture the node is no longer rendered
+	scene_invalidate_render_lists(scene_node_get_root(&scene_buffer->node));
 }
 
 static void scene_buffer_set_buffer(struct sway_scene_buffer *scene_buffer,
@@ -874,6 +935,7 @@ static void scene_buffer_handle_renderer_destroy(struct wl_listener *listener,
 		void *data) {
 	struct sway_scene_buffer *scene_buffer = wl_container_of(listener, scene_buffer, renderer_destroy);
 	scene_buffer_set_texture(scene_buffer, NULL);
+	scene_invalidate_render_lists(scene_node_get_root(&scene_buffer->node));
 }
 
 static void scene_buffer_set_texture(struct sway_scene_buffer *scene_buffer,
@@ -957,6 +1019,11 @@ void sway_scene_buffer_set_buffer_with_options(struct sway_scene_buffer *scene_b
 			scene_buffer->buffer_height != buffer->height;
 	}
 
+	// Opaqueness drives visibility culling, so a change in it needs a new
+	// render list even if the node geometry is the same
+	bool was_opaque = scene_buffer->buffer_is_opaque;
+	bool was_black_opaque = scene_buffer_is_black_opaque(scene_buffer);
+
 	// If this is a buffer change, check if it's a single pixel buffer.
 	// Cache that so we can still apply rendering optimisations even when
 	// the original buffer has been freed after texture upload.
@@ -984,6 +1051,11 @@ void sway_scene_buffer_set_buffer_with_options(struct sway_scene_buffer *scene_b
 	scene_buffer_set_wait_timeline(scene_buffer,
 		options->wait_timeline, options->wait_point);
 
+	if (!update && (was_opaque != scene_buffer->buffer_is_opaque ||
+			was_black_opaque != scene_buffer_is_black_opaque(scene_buffer))) {
+		scene_invalidate_render_lists(scene_node_get_root(&scene_buffer->node));
+	}
+
 	if (update) {
 		scene_node_update(&scene_buffer->node, NULL);
 		// updating the node will already damage the whole node for us. Return
@@ -1032,6 +1104,7 @@ void sway_scene_buffer_set_buffer_with_options(struct sway_scene_buffer *scene_b
 	pixman_region32_translate(&trans_damage, -box.x, -box.y);
 
 	struct sway_scene *scene = scene_node_get_root(&scene_buffer->node);
+	struct sway_workspace *workspace = scene_node_get_overview_workspace(&scene_buffer->node);
 	struct sway_scene_output *scene_output;
 	wl_list_for_each(scene_output, &scene->outputs, link) {
 		float output_scale = scene_output->output->scale;
@@ -1073,7 +1146,7 @@ void sway_scene_buffer_set_buffer_with_options(struct sway_scene_buffer *scene_b
 			(int)round((lx - scene_output->x) * output_scale),
 			(int)round((ly - scene_output->y) * output_scale));
 		output_to_buffer_coords(&output_damage, scene_output->output);
-		scene_output_damage(scene_output, &output_damage);
+		scene_output_damage_workspace(scene_output, workspace, &output_damage);
 		pixman_region32_fini(&output_damage);
 	}
 
@@ -1372,6 +1445,12 @@ void sway_scene_node_reparent(struct sway_scene_node *node,
 		scene_node_visibility(node, &visible);
 	}
 
+	// The update below only damages the thumbnail of the new workspace
+	struct sway_workspace *workspace = scene_node_get_overview_workspace(node);
+	if (workspace && workspace != scene_node_get_workspace(&new_parent->node)) {
+		scene_damage_outputs(scene_node_get_root(node), workspace, &visible);
+	}
+
 	wl_list_remove(&node->link);
 	node->parent = new_parent;
 	wl_list_insert(new_parent->children.prev, &node->link);
@@ -1507,8 +1586,9 @@ static void scene_entry_render(struct render_list_entry *entry, const struct ren
 
 	struct sway_workspace *workspace = scene_node_get_workspace(node);
 	float scale = workspace ? workspace->layout.workspaces.scale : 1.0f;
-	int dx = workspace ? workspace->layout.workspaces.x : 0;
-	int dy = workspace ? workspace->layout.workspaces.y : 0;
+	// Thumbnails are rendered at their own origin
+	int dx = workspace && !data->thumbnail ? workspace->layout.workspaces.x : 0;
+	int dy = workspace && !data->thumbnail ? workspace->layout.workspaces.y : 0;
 
 	pixman_region32_t render_region;
 	pixman_region32_init(&render_region);
@@ -1597,6 +1677,12 @@ static void scene_entry_render(struct render_list_entry *entry, const struct ren
 		struct wlr_texture *texture = scene_buffer_get_texture(scene_buffer,
 			data->output->output->renderer);
 		if (texture == NULL) {
+			if (data->thumbnail) {
+				// Try again with the next frame
+				pixman_region32_translate(&render_region, data->thumbnail->layout.workspaces.x,
+					data->thumbnail->layout.workspaces.y);
+				data->thumbnail->layout.workspaces.thumbnail.dirty = true;
+			}
 			scene_output_damage(data->output, &render_region);
 			break;
 		}
@@ -1733,6 +1819,7 @@ static void scene_node_output_update(struct sway_scene_node *node,
 static void scene_output_update_geometry(struct sway_scene_output *scene_output,
 		bool force_update) {
 	scene_output_damage_whole(scene_output);
+	scene_invalidate_render_lists(scene_output->scene);
 
 	scene_node_output_update(&scene_output->scene->tree.node,
 			&scene_output->scene->outputs, NULL, force_update ? scene_output : NULL);
@@ -1817,6 +1904,7 @@ struct sway_scene_output *sway_scene_output_create(struct sway_scene *scene,
 
 	wlr_damage_ring_init(&scene_output->damage_ring);
 	pixman_region32_init(&scene_output->pending_commit_damage);
+	pixman_region32_init(&scene_output->render_list_opaque);
 	wl_list_init(&scene_output->damage_highlight_regions);
 
 	int prev_output_index = -1;
@@ -1887,6 +1975,7 @@ void sway_scene_output_destroy(struct sway_scene_output *scene_output) {
 	wlr_addon_finish(&scene_output->addon);
 	wlr_damage_ring_finish(&scene_output->damage_ring);
 	pixman_region32_fini(&scene_output->pending_commit_damage);
+	pixman_region32_fini(&scene_output->render_list_opaque);
 	wl_list_remove(&scene_output->link);
 	wl_list_remove(&scene_output->output_commit.link);
 	wl_list_remove(&scene_output->output_damage.link);
@@ -2156,6 +2245,164 @@ static enum scene_direct_scanout_result scene_entry_try_direct_scanout(
 	return SCANOUT_SUCCESS;
 }
 
+static bool scene_output_render_list_valid(struct sway_scene_output *scene_output,
+		const struct render_data *render_data) {
+	struct sway_scene *scene = scene_output->scene;
+	return scene_output->render_list_valid &&
+		scene_output->render_list_serial == scene->render_list_serial &&
+		wlr_box_equal(&scene_output->render_list_box, &render_data->logical) &&
+		scene_output->render_list_scale == render_data->scale &&
+		scene_output->render_list_transform == render_data->transform &&
+		scene_output->render_list_calculate_visibility == scene->calculate_visibility &&
+		scene_output->render_list_highlight_transparent_region ==
+			scene->highlight_transparent_region;
+}
+
+static void scene_output_build_render_list(struct sway_scene_output *scene_output,
+		const struct render_data *render_data,
+		struct render_list_constructor_data *list_con, bool cull_background) {
+	struct sway_scene *scene = scene_output->scene;
+
+	list_con->render_list->size = 0;
+	scene_nodes_in_box(&scene->tree.node, &list_con->box,
+		construct_render_list_iterator, list_con);
+	array_realloc(list_con->render_list, list_con->render_list->size);
+
+	pixman_region32_clear(&scene_output->render_list_opaque);
+	if (cull_background) {
+		struct render_list_entry *list_data = list_con->render_list->data;
+		int list_len = list_con->render_list->size / sizeof(*list_data);
+		for (int i = list_len - 1; i >= 0; i--) {
+			struct render_list_entry *entry = &list_data[i];
+
+			// We must only cull opaque regions that are visible by the node.
+			// The node's visibility will have the knowledge of a black rect
+			// that may have been omitted from the render list via the black
+			// rect optimization. In order to ensure we don't cull background
+			// rendering in that black rect region, consider the node's visibility.
+			pixman_region32_t opaque;
+			pixman_region32_init(&opaque);
+			scene_node_opaque_region(entry->node, entry->x, entry->y, &opaque);
+			pixman_region32_intersect(&opaque, &opaque, &entry->node->visible);
+
+			pixman_region32_translate(&opaque, -scene_output->x, -scene_output->y);
+			logical_to_buffer_coords(&opaque, render_data, false);
+			pixman_region32_union(&scene_output->render_list_opaque,
+				&scene_output->render_list_opaque, &opaque);
+			pixman_region32_fini(&opaque);
+		}
+	}
+
+	scene_output->render_list_serial = scene->render_list_serial;
+	scene_output->render_list_box = render_data->logical;
+	scene_output->render_list_scale = render_data->scale;
+	scene_output->render_list_transform = render_data->transform;
+	scene_output->render_list_calculate_visibility = scene->calculate_visibility;
+	scene_output->render_list_highlight_transparent_region =
+		scene->highlight_transparent_region;
+}
+
+// Redraw the overview thumbnail of a workspace if it took damage since the
+// last frame. Returns false if there is no thumbnail to composite, and the
+// workspace has to be rendered directly.
+static bool scene_output_update_thumbnail(struct sway_workspace *workspace,
+		const struct render_data *render_data, struct wlr_swapchain *swapchain,
+		struct render_list_entry *list_data, int list_len) {
+	struct wlr_renderer *renderer = render_data->output->output->renderer;
+	int width = workspace->layout.workspaces.width;
+	int height = workspace->layout.workspaces.height;
+	if (width <= 0 || height <= 0) {
+		return false;
+	}
+
+	struct wlr_buffer *buffer = workspace->layout.workspaces.thumbnail.buffer;
+	if (buffer && (buffer->width != width || buffer->height != height)) {
+		layout_overview_workspaces_thumbnail_release(workspace);
+		buffer = NULL;
+	}
+	if (!buffer) {
+		buffer = wlr_allocator_create_buffer(swapchain->allocator, width, height,
+			&swapchain->format);
+		if (!buffer) {
+			sway_log(SWAY_DEBUG, "Failed to allocate thumbnail for workspace %s",
+				workspace->name);
+			return false;
+		}
+		workspace->layout.workspaces.thumbnail.buffer = buffer;
+		workspace->layout.workspaces.thumbnail.dirty = true;
+	}
+
+	if (!workspace->layout.workspaces.thumbnail.dirty &&
+			workspace->layout.workspaces.thumbnail.texture) {
+		return true;
+	}
+
+	if (workspace->layout.workspaces.thumbnail.texture) {
+		wlr_texture_destroy(workspace->layout.workspaces.thumbnail.texture);
+		workspace->layout.workspaces.thumbnail.texture = NULL;
+	}
+	// Cleared before rendering, so entries that cannot be rendered yet can
+	// set it again
+	workspace->layout.workspaces.thumbnail.dirty = false;
+
+	struct wlr_render_pass *render_pass = wlr_renderer_begin_buffer_pass(renderer,
+		buffer, NULL);
+	if (!render_pass) {
+		return false;
+	}
+
+	struct render_data data = *render_data;
+	data.thumbnail = workspace;
+	data.render_pass = render_pass;
+	pixman_region32_init_rect(&data.damage, 0, 0, width, height);
+
+	wlr_render_pass_add_rect(render_pass, &(struct wlr_render_rect_options){
+		.box = { .width = width, .height = height },
+		.color = { .r = 0, .g = 0, .b = 0, .a = 0 },
+		.blend_mode = WLR_RENDER_BLEND_MODE_NONE,
+	});
+
+	for (int i = list_len - 1; i >= 0; i--) {
+		struct render_list_entry *entry = &list_data[i];
+		if (scene_node_get_workspace(entry->node) == workspace) {
+			scene_entry_render(entry, &data);
+		}
+	}
+	pixman_region32_fini(&data.damage);
+
+	if (!wlr_render_pass_submit(render_pass)) {
+		workspace->layout.workspaces.thumbnail.dirty = true;
+		return false;
+	}
+
+	workspace->layout.workspaces.thumbnail.texture =
+		wlr_texture_from_buffer(renderer, buffer);
+	return workspace->layout.workspaces.thumbnail.texture != NULL;
+}
+
+static void scene_output_render_thumbnails(list_t *workspaces,
+		const struct render_data *render_data) {
+	for (int i = 0; i < workspaces->length; ++i) {
+		struct sway_workspace *workspace = workspaces->items[i];
+		struct wlr_texture *texture = workspace->layout.workspaces.thumbnail.texture;
+		if (!texture) {
+			continue;
+		}
+
+		wlr_render_pass_add_texture(render_data->render_pass, &(struct wlr_render_texture_options) {
+			.texture = texture,
+			.dst_box = {
+				.x = workspace->layout.workspaces.x,
+				.y = workspace->layout.workspaces.y,
+				.width = texture->width,
+				.height = texture->height,
+			},
+			.clip = &render_data->damage,
+			.blend_mode = WLR_RENDER_BLEND_MODE_PREMULTIPLIED,
+		});
+	}
+}
+
 bool sway_scene_output_needs_frame(struct sway_scene_output *scene_output) {
 	return scene_output->output->needs_frame ||
 		!pixman_region32_empty(&scene_output->pending_commit_damage) ||
@@ -2264,10 +2511,6 @@ bool sway_scene_output_build_state(struct sway_scene_output *scene_output,
 		render_data.scale = state->scale;
 	}
 
-	if (layout_overview_workspaces_enabled()) {
-		scene_output_damage_whole(scene_output);
-	}
-
 	render_data.trans_width = resolution_width;
 	render_data.trans_height = resolution_height;
 	wlr_output_transform_coords(render_data.transform,
@@ -2284,10 +2527,15 @@ bool sway_scene_output_build_state(struct sway_scene_output *scene_output,
 		.fractional_scale = floor(render_data.scale) != render_data.scale,
 	};
 
-	list_con.render_list->size = 0;
-	scene_nodes_in_box(&scene_output->scene->tree.node, &list_con.box,
-		construct_render_list_iterator, &list_con);
-	array_realloc(list_con.render_list, list_con.render_list->size);
+	// The overview scales and moves workspaces without updating the scene
+	// nodes, so it always needs a new list
+	bool overview = layout_overview_workspaces_enabled();
+	bool cull_background = list_con.calculate_visibility && !overview;
+	if (overview || !scene_output_render_list_valid(scene_output, &render_data)) {
+		scene_output_build_render_list(scene_output, &render_data, &list_con,
+			cull_background);
+		scene_output->render_list_valid = !overview;
+	}
 
 	struct render_list_entry *list_data = list_con.render_list->data;
 	int list_len = list_con.render_list->size / sizeof(*list_data);
@@ -2401,6 +2649,21 @@ bool sway_scene_output_build_state(struct sway_scene_output *scene_output,
 		timer->pre_render_duration = timespec_to_nsec(&duration);
 	}
 
+	// In the overview, workspaces are rendered into their thumbnails first,
+	// and the output pass only composites them
+	list_t *thumbnails = NULL;
+	if (overview) {
+		thumbnails = create_list();
+		for (int i = list_len - 1; i >= 0; i--) {
+			struct sway_workspace *workspace = scene_node_get_workspace(list_data[i].node);
+			if (workspace && list_find(thumbnails, workspace) == -1) {
+				list_add(thumbnails, workspace);
+				scene_output_update_thumbnail(workspace, &render_data, swapchain,
+					list_data, list_len);
+			}
+		}
+	}
+
 	scene_output->in_point++;
 	struct wlr_render_pass *render_pass = wlr_renderer_begin_buffer_pass(output->renderer, buffer,
 			&(struct wlr_buffer_pass_options){
@@ -2410,6 +2673,7 @@ bool sway_scene_output_build_state(struct sway_scene_output *scene_output,
 		.signal_point = scene_output->in_point,
 	});
 	if (render_pass == NULL) {
+		list_free(thumbnails);
 		wlr_buffer_unlock(buffer);
 		return false;
 	}
@@ -2427,25 +2691,9 @@ bool sway_scene_output_build_state(struct sway_scene_output *scene_output,
 	// Cull areas of the background that are occluded by opaque regions of
 	// scene nodes above. Those scene nodes will just render atop having us
 	// never see the background.
-	if (scene_output->scene->calculate_visibility && !layout_overview_workspaces_enabled()) {
-		for (int i = list_len - 1; i >= 0; i--) {
-			struct render_list_entry *entry = &list_data[i];
-
-			// We must only cull opaque regions that are visible by the node.
-			// The node's visibility will have the knowledge of a black rect
-			// that may have been omitted from the render list via the black
-			// rect optimization. In order to ensure we don't cull background
-			// rendering in that black rect region, consider the node's visibility.
-			pixman_region32_t opaque;
-			pixman_region32_init(&opaque);
-			scene_node_opaque_region(entry->node, entry->x, entry->y, &opaque);
-			pixman_region32_intersect(&opaque, &opaque, &entry->node->visible);
-
-			pixman_region32_translate(&opaque, -scene_output->x, -scene_output->y);
-			logical_to_buffer_coords(&opaque, &render_data, false);
-			pixman_region32_subtract(&background, &background, &opaque);
-			pixman_region32_fini(&opaque);
-		}
+	if (cull_background) {
+		pixman_region32_subtract(&background, &background,
+			&scene_output->render_list_opaque);
 
 		if (floor(render_data.scale) != render_data.scale) {
 			wlr_region_expand(&background, &background, 1);
@@ -2463,8 +2711,19 @@ bool sway_scene_output_build_state(struct sway_scene_output *scene_output,
 	});
 	pixman_region32_fini(&background);
 
+	bool thumbnails_rendered = false;
 	for (int i = list_len - 1; i >= 0; i--) {
 		struct render_list_entry *entry = &list_data[i];
+		struct sway_workspace *workspace = thumbnails ?
+			scene_node_get_workspace(entry->node) : NULL;
+		if (workspace && workspace->layout.workspaces.thumbnail.texture) {
+			// Thumbnails never overlap, so they all go in at the first one
+			if (!thumbnails_rendered) {
+				scene_output_render_thumbnails(thumbnails, &render_data);
+				thumbnails_rendered = true;
+			}
+			continue;
+		}
 		scene_entry_render(entry, &render_data);
 
 		if (entry->node->type == SWAY_SCENE_NODE_BUFFER) {
@@ -2501,6 +2760,8 @@ bool sway_scene_output_build_state(struct sway_scene_output *scene_output,
 		}
 	}
 
+	list_free(thumbnails);
+
 	wlr_output_add_software_cursors_to_render_pass(output, render_pass, &render_data.damage);
 	pixman_region32_fini(&render_data.damage);
 
@@ -2608,6 +2869,31 @@ void sway_scene_output_for_each_buffer(struct sway_scene_output *scene_output,
 		iterator, user_data);
 }
 
+bool sway_scene_output_for_each_rendered_buffer(struct sway_scene_output *scene_output,
+		sway_scene_buffer_iterator_func_t iterator, void *user_data) {
+	struct wlr_output *output = scene_output->output;
+	struct wlr_box box = { .x = scene_output->x, .y = scene_output->y };
+	wlr_output_effective_resolution(output, &box.width, &box.height);
+	if (!scene_output->render_list_valid ||
+			scene_output->render_list_serial != scene_output->scene->render_list_serial ||
+			!wlr_box_equal(&scene_output->render_list_box, &box) ||
+			scene_output->render_list_scale != output->scale ||
+			scene_output->render_list_transform != output->transform) {
+		return false;
+	}
+
+	struct render_list_entry *list_data = scene_output->render_list.data;
+	int list_len = scene_output->render_list.size / sizeof(*list_data);
+	for (int i = 0; i < list_len; i++) {
+		struct render_list_entry *entry = &list_data[i];
+		if (entry->node->type == SWAY_SCENE_NODE_BUFFER) {
+			iterator(sway_scene_buffer_from_node(entry->node),
+				entry->x, entry->y, user_data);
+		}
+	}
+	return true;
+}
+
 float scene_node_get_parent_content_scale(struct sway_scene_node *node) {
 	struct sway_scene_tree *tree;
 	if (node->type == SWAY_SCENE_NODE_TREE) {
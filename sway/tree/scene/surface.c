@@ -168,6 +168,7 @@ static void surface_reconfigure(struct sway_scene_surface *scene_surface) {
 	sway_scene_buffer_set_dest_size(scene_buffer, round(width * total_scale), round(height * total_scale));
 	sway_scene_buffer_set_transform(scene_buffer, state->transform);
 	sway_scene_buffer_set_opacity(scene_buffer, opacity);
+	scene_buffer->opacity_configured = false;
 
 	scene_buffer_unmark_client_buffer(scene_buffer);
 
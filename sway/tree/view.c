@@ -79,6 +79,7 @@ void view_destroy(struct sway_view *view) {
 	}
 	wl_list_remove(&view->events.unmap.listener_list);
 	list_free(view->executed_criteria);
+	criteria_cache_destroy(view->criteria_cache);
 
 	view_assign_ctx(view, NULL);
 	sway_scene_node_destroy(&view->scene_tree->node);
@@ -495,7 +496,7 @@ void view_execute_criteria(struct sway_view *view) {
 		sway_log(SWAY_DEBUG, "for_window '%s' matches view %p, cmd: '%s'",
 				criteria->raw, view, criteria->cmdlist);
 		list_add(view->executed_criteria, criteria);
-		list_t *res_list = execute_command(
+		list_t *res_list = execute_command_program(&criteria->program,
 				criteria->cmdlist, NULL, view->container);
 		while (res_list->length) {
 			struct cmd_results *res = res_list->items[0];
@@ -147,6 +147,7 @@ void workspace_destroy(struct sway_workspace *workspace) {
 	scene_node_disown_children(workspace->layers.fullscreen);
 	sway_scene_node_destroy(&workspace->layers.tiling->node);
 	sway_scene_node_destroy(&workspace->layers.fullscreen->node);
+	layout_overview_workspaces_thumbnail_release(workspace);
 
 	free(workspace->name);
 	free(workspace->representation);
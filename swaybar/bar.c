@@ -1,6 +1,7 @@
 #include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <json.h>
 #include <poll.h>
 #include <signal.h>
 #include <stdbool.h>
@@ -53,6 +54,8 @@ static void swaybar_output_free(struct swaybar_output *output) {
 	wl_output_destroy(output->output);
 	destroy_buffer(&output->buffers[0]);
 	destroy_buffer(&output->buffers[1]);
+	wl_array_release(&output->render_items);
+	render_cache_finish(output);
 	free_hotspots(&output->hotspots);
 	free_workspaces(&output->workspaces);
 	wl_list_remove(&output->link);
@@ -129,6 +132,7 @@ void destroy_layer_surface(struct swaybar_output *output) {
 	output->layer_surface = NULL;
 	output->width = 0;
 	output->frame_scheduled = false;
+	output->render_valid = false;
 }
 
 void set_bar_dirty(struct swaybar *bar) {
@@ -352,6 +356,8 @@ static void handle_global(void *data, struct wl_registry *registry,
 		wl_list_init(&output->workspaces);
 		wl_list_init(&output->hotspots);
 		wl_list_init(&output->link);
+		wl_array_init(&output->render_items);
+		wl_array_init(&output->render_cache);
 		if (bar->xdg_output_manager != NULL) {
 			add_xdg_output(output);
 		}
@@ -553,6 +559,9 @@ void bar_teardown(struct swaybar *bar) {
 	}
 	close(bar->ipc_event_socketfd);
 	close(bar->ipc_socketfd);
+	if (bar->ipc_tokener) {
+		json_tokener_free(bar->ipc_tokener);
+	}
 	if (bar->status) {
 		status_line_free(bar->status);
 	}
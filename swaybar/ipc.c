@@ -350,20 +350,12 @@ static bool ipc_parse_config(
 	return true;
 }
 
-bool ipc_get_workspaces(struct swaybar *bar) {
+static bool ipc_parse_workspaces(struct swaybar *bar, json_object *results) {
 	struct swaybar_output *output;
 	wl_list_for_each(output, &bar->outputs, link) {
 		free_workspaces(&output->workspaces);
 		output->focused = false;
 	}
-	uint32_t len = 0;
-	char *res = ipc_single_command(bar->ipc_socketfd,
-			IPC_GET_WORKSPACES, NULL, &len);
-	json_object *results = json_tokener_parse(res);
-	if (!results) {
-		free(res);
-		return false;
-	}
 
 	bar->visible_by_urgency = false;
 	size_t length = json_object_array_length(results);
@@ -416,28 +408,34 @@ bool ipc_get_workspaces(struct swaybar *bar) {
 			}
 		}
 	}
-	json_object_put(results);
-	free(res);
 	return determine_bar_visibility(bar, false);
 }
 
-bool ipc_get_scroller(struct swaybar *bar) {
+bool ipc_get_workspaces(struct swaybar *bar) {
 	uint32_t len = 0;
 	char *res = ipc_single_command(bar->ipc_socketfd,
-			IPC_GET_SCROLLER, NULL, &len);
+			IPC_GET_WORKSPACES, NULL, &len);
 	json_object *results = json_tokener_parse(res);
 	if (!results) {
+		struct swaybar_output *output;
+		wl_list_for_each(output, &bar->outputs, link) {
+			free_workspaces(&output->workspaces);
+			output->focused = false;
+		}
 		free(res);
 		return false;
 	}
+	bool dirty = ipc_parse_workspaces(bar, results);
+	json_object_put(results);
+	free(res);
+	return dirty;
+}
 
+static bool ipc_parse_scroller(struct swaybar *bar, json_object *s) {
 	free(bar->scroll_mode);
 	free(bar->scroll_insert);
 	free(bar->scroll_reorder);
 
-	json_object *s;
-	json_object_object_get_ex(results, "scroller", &s);
-
 	json_object *overview, *scaled, *scale, *mode, *insert, *focus,
 		*center_horiz, *center_vert, *reorder;
 
@@ -461,15 +459,13 @@ bool ipc_get_scroller(struct swaybar *bar) {
 	bar->scroll_center_vertical = json_object_get_boolean(center_vert);
 	bar->scroll_reorder = strdup(json_object_get_string(reorder));
 
-	json_object_put(results);
-	free(res);
 	return determine_bar_visibility(bar, false);
 }
 
-bool ipc_get_trails(struct swaybar *bar) {
+bool ipc_get_scroller(struct swaybar *bar) {
 	uint32_t len = 0;
 	char *res = ipc_single_command(bar->ipc_socketfd,
-			IPC_GET_TRAILS, NULL, &len);
+			IPC_GET_SCROLLER, NULL, &len);
 	json_object *results = json_tokener_parse(res);
 	if (!results) {
 		free(res);
@@ -477,8 +473,14 @@ bool ipc_get_trails(struct swaybar *bar) {
 	}
 
 	json_object *s;
-	json_object_object_get_ex(results, "trails", &s);
+	json_object_object_get_ex(results, "scroller", &s);
+	bool dirty = ipc_parse_scroller(bar, s);
+	json_object_put(results);
+	free(res);
+	return dirty;
+}
 
+static bool ipc_parse_trails(struct swaybar *bar, json_object *s) {
 	json_object *length, *active, *trail_length;
 
 	json_object_object_get_ex(s, "length", &length);
@@ -489,9 +491,41 @@ bool ipc_get_trails(struct swaybar *bar) {
 	bar->trails_active = json_object_get_int(active);
 	bar->trail_length = json_object_get_int(trail_length);
 
+	return determine_bar_visibility(bar, false);
+}
+
+bool ipc_get_trails(struct swaybar *bar) {
+	uint32_t len = 0;
+	char *res = ipc_single_command(bar->ipc_socketfd,
+			IPC_GET_TRAILS, NULL, &len);
+	json_object *results = json_tokener_parse(res);
+	if (!results) {
+		free(res);
+		return false;
+	}
+
+	json_object *s;
+	json_object_object_get_ex(results, "trails", &s);
+	bool dirty = ipc_parse_trails(bar, s);
 	json_object_put(results);
 	free(res);
-	return determine_bar_visibility(bar, false);
+	return dirty;
+}
+
+// Updates whatever the compositor sent, without asking for anything else
+static bool handle_state(struct swaybar *bar, json_object *event) {
+	bool dirty = false;
+	json_object *workspaces, *scroller, *trails;
+	if (json_object_object_get_ex(event, "workspaces", &workspaces)) {
+		dirty |= ipc_parse_workspaces(bar, workspaces);
+	}
+	if (json_object_object_get_ex(event, "scroller", &scroller)) {
+		dirty |= ipc_parse_scroller(bar, scroller);
+	}
+	if (json_object_object_get_ex(event, "trails", &trails)) {
+		dirty |= ipc_parse_trails(bar, trails);
+	}
+	return dirty;
 }
 
 void ipc_execute_binding(struct swaybar *bar, struct swaybar_binding *bind) {
@@ -512,8 +546,10 @@ bool ipc_initialize(struct swaybar *bar) {
 	}
 	free(res);
 
+	// The state event carries the workspaces, scroller and trails, so they
+	// don't have to be requested on every change
 	char *subscribe =
-		"[ \"barconfig_update\", \"bar_state_update\", \"mode\", \"workspace\", \"scroller\", \"trails\" ]";
+		"[ \"barconfig_update\", \"bar_state_update\", \"mode\", \"state\" ]";
 	len = strlen(subscribe);
 	free(ipc_single_command(bar->ipc_event_socketfd,
 			IPC_SUBSCRIBE, subscribe, &len));
@@ -554,6 +590,7 @@ static bool handle_barconfig_update(struct swaybar *bar, const char *payload,
 
 	struct swaybar_config *oldcfg = bar->config;
 	bar->config = newcfg;
+	bar->config_serial++;
 
 	struct swaybar_output *output, *tmp_output;
 	wl_list_for_each_safe(output, tmp_output, &bar->outputs, link) {
@@ -632,17 +669,20 @@ bool handle_ipc_readable(struct swaybar *bar) {
 
 	// The default depth of 32 is too small to represent some nested layouts, but
 	// we can't pass INT_MAX here because json-c (as of this writing) prefaults
-	// all the memory for its stack.
-	json_tokener *tok = json_tokener_new_ex(JSON_MAX_DEPTH);
-	if (!tok) {
-		sway_log_errno(SWAY_ERROR, "failed to create tokener");
-		free_ipc_response(resp);
-		return false;
+	// all the memory for its stack. So the tokener is kept for every event.
+	if (!bar->ipc_tokener) {
+		bar->ipc_tokener = json_tokener_new_ex(JSON_MAX_DEPTH);
+		if (!bar->ipc_tokener) {
+			sway_log_errno(SWAY_ERROR, "failed to create tokener");
+			free_ipc_response(resp);
+			return false;
+		}
 	}
+	json_tokener *tok = bar->ipc_tokener;
+	json_tokener_reset(tok);
 
 	json_object *result = json_tokener_parse_ex(tok, resp->payload, -1);
 	enum json_tokener_error err = json_tokener_get_error(tok);
-	json_tokener_free(tok);
 
 	if (err != json_tokener_success) {
 		sway_log(SWAY_ERROR, "failed to parse payload as json: %s",
@@ -653,8 +693,8 @@ bool handle_ipc_readable(struct swaybar *bar) {
 
 	bool bar_is_dirty = true;
 	switch (resp->type) {
-	case IPC_EVENT_WORKSPACE:
-		bar_is_dirty = ipc_get_workspaces(bar);
+	case IPC_EVENT_STATE:
+		bar_is_dirty = handle_state(bar, result);
 		break;
 	case IPC_EVENT_MODE: {
 		json_object *json_change, *json_pango_markup;
@@ -675,12 +715,6 @@ bool handle_ipc_readable(struct swaybar *bar) {
 		}
 		break;
 	}
-	case IPC_EVENT_SCROLLER:
-		bar_is_dirty = ipc_get_scroller(bar);
-		break;
-	case IPC_EVENT_TRAILS:
-		bar_is_dirty = ipc_get_trails(bar);
-		break;
 	case IPC_EVENT_BARCONFIG_UPDATE:
 		bar_is_dirty = handle_barconfig_update(bar, resp->payload, result);
 		break;
@@ -1,6 +1,7 @@
 #include <assert.h>
 #include <linux/input-event-codes.h>
 #include <limits.h>
+#include <math.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
@@ -15,6 +16,7 @@
 #include "swaybar/status_line.h"
 #include "log.h"
 #if HAVE_TRAY
+#include "swaybar/tray/item.h"
 #include "swaybar/tray/tray.h"
 #endif
 #include "wlr-layer-shell-unstable-v1-client-protocol.h"
@@ -30,8 +32,274 @@ struct render_context {
 	cairo_font_options_t *textaa_safe;
 	uint32_t background_color;
 	bool has_transparency;
+	struct wl_array items; // struct render_item
+
+	// Frame background and render_frame_hash(), which key the item cache
+	uint32_t frame_background;
+	uint32_t frame_hash;
+	// Item being drawn into a cache image, see render_cache_begin()
+	struct {
+		cairo_t *cairo;
+		bool has_transparency;
+		struct wl_list *hotspots;
+	} saved;
 };
 
+/**
+ * A horizontal span of the bar drawn by a single workspace button, status
+ * block, indicator or tray icon. The hash covers everything the drawing depends on
+ * that isn't part of the bar configuration, so an item with the same span and
+ * hash as in the previous frame doesn't need to be drawn again.
+ */
+struct render_item {
+	double x0, x1;
+	uint32_t hash;
+};
+
+/**
+ * The pixels of an item, kept from one frame to the next so an item drawn
+ * again with the same hash is copied instead of laid out and rasterized. The
+ * image covers the device pixels of the span, over the bar background. An
+ * entry that isn't used in a frame is dropped at the end of it.
+ */
+struct render_cache_entry {
+	uint32_t hash, frame_hash;
+	double width;
+	double offset; // fraction of a device pixel the span started at
+	uint32_t height; // returned by the render function
+	uint32_t background_color; // the context's after the item
+	bool has_transparency;
+	bool has_hotspot;
+	struct swaybar_hotspot hotspot; // x relative to the span
+	cairo_surface_t *image; // NULL for an empty span
+	bool used;
+};
+
+// Damage is extended by this to cover text overhanging its item
+static const int ITEM_DAMAGE_MARGIN = 2;
+
+static uint32_t hash_bytes(uint32_t hash, const void *data, size_t size) {
+	// FNV-1a
+	const unsigned char *bytes = data;
+	for (size_t i = 0; i < size; ++i) {
+		hash = (hash ^ bytes[i]) * 16777619u;
+	}
+	return hash;
+}
+
+static uint32_t hash_u32(uint32_t hash, uint32_t value) {
+	return hash_bytes(hash, &value, sizeof(value));
+}
+
+static uint32_t hash_str(uint32_t hash, const char *str) {
+	if (!str) {
+		return hash_u32(hash, 0xFFFFFFFF);
+	}
+	return hash_bytes(hash, str, strlen(str) + 1);
+}
+
+// Every item depends on the background it is drawn over, which decides how
+// its text is antialiased
+static uint32_t render_item_hash(struct render_context *ctx) {
+	uint32_t hash = hash_u32(2166136261u, ctx->background_color);
+	return hash_u32(hash, ctx->output->focused);
+}
+
+static void render_item_add(struct render_context *ctx, double x0, double x1,
+		uint32_t hash) {
+	struct render_item *item = wl_array_add(&ctx->items, sizeof(*item));
+	if (!item) {
+		return;
+	}
+	*item = (struct render_item){
+		.x0 = x0 < x1 ? x0 : x1,
+		.x1 = x0 < x1 ? x1 : x0,
+		.hash = hash,
+	};
+}
+
+// Looks up the image of an item with this hash, drawn for the same frame
+// parameters and scale. x is the left edge of the item, or its right edge if
+// it grows to the left.
+static struct render_cache_entry *render_cache_find(struct render_context *ctx,
+		uint32_t hash, double x, bool leftward) {
+	struct swaybar_output *output = ctx->output;
+	struct render_cache_entry *entry;
+	wl_array_for_each(entry, &output->render_cache) {
+		if (entry->hash != hash || entry->frame_hash != ctx->frame_hash) {
+			continue;
+		}
+		// The image can only be copied to the same device pixel phase
+		double x0 = leftward ? x - entry->width : x;
+		double origin = x0 * output->scale - entry->offset;
+		if (fabs(origin - round(origin)) < 1e-6) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+static void render_cache_draw(struct render_context *ctx,
+		struct render_cache_entry *entry, double x0) {
+	if (!entry->image) {
+		return;
+	}
+	struct swaybar_output *output = ctx->output;
+	cairo_t *cairo = ctx->cairo;
+	cairo_save(cairo);
+	cairo_rectangle(cairo, x0, 0, entry->width, output->height);
+	cairo_clip(cairo);
+	cairo_identity_matrix(cairo);
+	cairo_set_operator(cairo, CAIRO_OPERATOR_SOURCE);
+	cairo_set_source_surface(cairo, entry->image,
+		round(x0 * output->scale - entry->offset), 0);
+	cairo_paint(cairo);
+	cairo_restore(cairo);
+}
+
+// Draws a cached item with its left edge at x0, and replays what drawing it
+// did to the context. Returns the hotspot of the item, for the caller to set
+// its data, if it had one.
+static struct swaybar_hotspot *render_cache_paint(struct render_context *ctx,
+		struct render_cache_entry *entry, double x0) {
+	entry->used = true;
+	render_cache_draw(ctx, entry, x0);
+	ctx->background_color = entry->background_color;
+	ctx->has_transparency |= entry->has_transparency;
+	render_item_add(ctx, x0, x0 + entry->width, entry->hash);
+	if (!entry->has_hotspot) {
+		return NULL;
+	}
+	struct swaybar_hotspot *hotspot = calloc(1, sizeof(struct swaybar_hotspot));
+	if (!hotspot) {
+		return NULL;
+	}
+	*hotspot = entry->hotspot;
+	hotspot->x += x0;
+	wl_list_insert(&ctx->output->hotspots, &hotspot->link);
+	return hotspot;
+}
+
+// Redirects the drawing of an item that isn't cached to a recording of its
+// own, over the bar background, so render_cache_end() can keep its pixels.
+static void render_cache_begin(struct render_context *ctx) {
+	cairo_surface_t *recorder = cairo_recording_surface_create(
+			CAIRO_CONTENT_COLOR_ALPHA, NULL);
+	cairo_t *cairo = cairo_create(recorder);
+	cairo_surface_destroy(recorder);
+	cairo_scale(cairo, ctx->output->scale, ctx->output->scale);
+	cairo_set_antialias(cairo, CAIRO_ANTIALIAS_BEST);
+	cairo_set_operator(cairo, CAIRO_OPERATOR_SOURCE);
+	cairo_set_source_u32(cairo, ctx->frame_background);
+	cairo_paint(cairo);
+
+	ctx->saved.cairo = ctx->cairo;
+	ctx->saved.has_transparency = ctx->has_transparency;
+	ctx->saved.hotspots = ctx->output->hotspots.next;
+	ctx->cairo = cairo;
+	ctx->has_transparency = false;
+}
+
+static void render_cache_restore(struct render_context *ctx) {
+	ctx->cairo = ctx->saved.cairo;
+	ctx->has_transparency |= ctx->saved.has_transparency;
+	ctx->saved.cairo = NULL;
+}
+
+// Drops the recording of an item that returned without drawing
+static void render_cache_abort(struct render_context *ctx) {
+	cairo_destroy(ctx->cairo);
+	render_cache_restore(ctx);
+}
+
+// Rasterizes the item drawn since render_cache_begin() over [x0, x1), keeps it
+// in the cache and draws it on the bar
+static void render_cache_end(struct render_context *ctx, uint32_t hash,
+		double x0, double x1, uint32_t height) {
+	struct swaybar_output *output = ctx->output;
+	cairo_t *item = ctx->cairo;
+	bool has_transparency = ctx->has_transparency;
+	struct wl_list *hotspots = ctx->saved.hotspots;
+	render_cache_restore(ctx);
+	if (x1 < x0) {
+		double tmp = x0;
+		x0 = x1;
+		x1 = tmp;
+	}
+
+	struct render_cache_entry entry = {
+		.hash = hash,
+		.frame_hash = ctx->frame_hash,
+		.width = x1 - x0,
+		.offset = x0 * output->scale - floor(x0 * output->scale),
+		.height = height,
+		.background_color = ctx->background_color,
+		.has_transparency = has_transparency,
+		.used = true,
+	};
+	if (output->hotspots.next != hotspots) {
+		// The hotspot the item added, it is inserted at the head
+		struct swaybar_hotspot *hotspot =
+			wl_container_of(output->hotspots.next, hotspot, link);
+		entry.has_hotspot = true;
+		entry.hotspot = *hotspot;
+		entry.hotspot.x -= x0;
+		entry.hotspot.data = NULL;
+	}
+	int px0 = floor(x0 * output->scale);
+	int px1 = ceil(x1 * output->scale);
+	if (px1 > px0) {
+		entry.image = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+			px1 - px0, output->height * output->scale);
+		cairo_t *cairo = cairo_create(entry.image);
+		cairo_set_operator(cairo, CAIRO_OPERATOR_SOURCE);
+		cairo_set_source_surface(cairo, cairo_get_target(item), -px0, 0);
+		cairo_paint(cairo);
+		cairo_destroy(cairo);
+	}
+	cairo_destroy(item);
+
+	// Drawn from the image like a cached item, so both give the same pixels
+	render_cache_draw(ctx, &entry, x0);
+	struct render_cache_entry *cached = wl_array_add(&output->render_cache,
+		sizeof(*cached));
+	if (!cached) {
+		cairo_surface_destroy(entry.image);
+		return;
+	}
+	*cached = entry;
+}
+
+// Drops the images no item used in this frame
+static void render_cache_prune(struct swaybar_output *output) {
+	struct wl_array kept;
+	wl_array_init(&kept);
+	struct render_cache_entry *entry;
+	wl_array_for_each(entry, &output->render_cache) {
+		struct render_cache_entry *copy = NULL;
+		if (entry->used) {
+			copy = wl_array_add(&kept, sizeof(*copy));
+		}
+		if (copy) {
+			*copy = *entry;
+			copy->used = false;
+		} else {
+			cairo_surface_destroy(entry->image);
+		}
+	}
+	wl_array_release(&output->render_cache);
+	output->render_cache = kept;
+}
+
+void render_cache_finish(struct swaybar_output *output) {
+	struct render_cache_entry *entry;
+	wl_array_for_each(entry, &output->render_cache) {
+		cairo_surface_destroy(entry->image);
+	}
+	wl_array_release(&output->render_cache);
+	wl_array_init(&output->render_cache);
+}
+
 static void choose_text_aa_mode(struct render_context *ctx, uint32_t fontcolor) {
 	uint32_t salpha = fontcolor & 0xFF;
 	uint32_t balpha = ctx->background_color & 0xFF;
@@ -55,7 +323,16 @@ static uint32_t render_status_line_error(struct render_context *ctx, double *x)
 	}
 
 	uint32_t height = output->height;
+	uint32_t hash = hash_str(render_item_hash(ctx), error);
+	double x0 = *x;
+	struct render_cache_entry *cached = render_cache_find(ctx, hash, *x, true);
+	if (cached) {
+		*x -= cached->width;
+		render_cache_paint(ctx, cached, *x);
+		return cached->height;
+	}
 
+	render_cache_begin(ctx);
 	cairo_t *cairo = ctx->cairo;
 	cairo_set_source_u32(cairo, 0xFF0000FF);
 
@@ -71,6 +348,7 @@ static uint32_t render_status_line_error(struct render_context *ctx, double *x)
 	uint32_t ideal_surface_height = ideal_height;
 	if (!output->bar->config->height &&
 			output->height < ideal_surface_height) {
+		render_cache_abort(ctx);
 		return ideal_surface_height;
 	}
 	*x -= text_width + margin;
@@ -80,6 +358,8 @@ static uint32_t render_status_line_error(struct render_context *ctx, double *x)
 	choose_text_aa_mode(ctx, 0xFF0000FF);
 	render_text(cairo, font, 1, false, "%s", error);
 	*x -= margin;
+	render_item_add(ctx, x0, *x, hash);
+	render_cache_end(ctx, hash, x0, *x, output->height);
 	return output->height;
 }
 
@@ -90,6 +370,16 @@ static uint32_t render_status_line_text(struct render_context *ctx, double *x) {
 		return 0;
 	}
 
+	uint32_t hash = hash_str(render_item_hash(ctx), text);
+	double x0 = *x;
+	struct render_cache_entry *cached = render_cache_find(ctx, hash, *x, true);
+	if (cached) {
+		*x -= cached->width;
+		render_cache_paint(ctx, cached, *x);
+		return cached->height;
+	}
+
+	render_cache_begin(ctx);
 	cairo_t *cairo = ctx->cairo;
 	struct swaybar_config *config = output->bar->config;
 	uint32_t fontcolor = output->focused ?
@@ -107,6 +397,7 @@ static uint32_t render_status_line_text(struct render_context *ctx, double *x) {
 	uint32_t ideal_surface_height = ideal_height;
 	if (!output->bar->config->height &&
 			output->height < ideal_surface_height) {
+		render_cache_abort(ctx);
 		return ideal_surface_height;
 	}
 
@@ -117,6 +408,8 @@ static uint32_t render_status_line_text(struct render_context *ctx, double *x) {
 	choose_text_aa_mode(ctx, fontcolor);
 	render_text(cairo, config->font_description, 1, config->pango_markup, "%s", text);
 	*x -= margin;
+	render_item_add(ctx, x0, *x, hash);
+	render_cache_end(ctx, hash, x0, *x, output->height);
 	return output->height;
 }
 
@@ -186,6 +479,36 @@ static uint32_t render_status_block(struct render_context *ctx,
 		text = block->short_text;
 	}
 
+	uint32_t hash = render_item_hash(ctx);
+	hash = hash_str(hash, text);
+	hash = hash_str(hash, block->min_width_str);
+	hash = hash_str(hash, block->align);
+	hash = hash_u32(hash, block->urgent | block->color_set << 1 |
+		block->separator << 2 | block->markup << 3 |
+		block->border_set << 4 | edge << 5 |
+		ctx->output->bar->status->click_events << 6);
+	hash = hash_u32(hash, block->min_width);
+	hash = hash_u32(hash, block->color);
+	hash = hash_u32(hash, block->background);
+	hash = hash_u32(hash, block->border);
+	hash = hash_u32(hash, block->separator_block_width);
+	hash = hash_u32(hash, block->border_top);
+	hash = hash_u32(hash, block->border_bottom);
+	hash = hash_u32(hash, block->border_left);
+	hash = hash_u32(hash, block->border_right);
+	double x0 = *x;
+	struct render_cache_entry *cached = render_cache_find(ctx, hash, *x, true);
+	if (cached) {
+		*x -= cached->width;
+		struct swaybar_hotspot *hotspot = render_cache_paint(ctx, cached, *x);
+		if (hotspot) {
+			hotspot->data = block;
+			block->ref_count++;
+		}
+		return cached->height;
+	}
+
+	render_cache_begin(ctx);
 	cairo_t *cairo = ctx->cairo;
 	struct swaybar_output *output = ctx->output;
 	struct swaybar_config *config = output->bar->config;
@@ -212,6 +535,7 @@ static uint32_t render_status_block(struct render_context *ctx,
 	uint32_t ideal_surface_height = ideal_height;
 	if (!output->bar->config->height &&
 			output->height < ideal_surface_height) {
+		render_cache_abort(ctx);
 		return ideal_surface_height;
 	}
 
@@ -235,6 +559,7 @@ static uint32_t render_status_block(struct render_context *ctx,
 			uint32_t _ideal_surface_height = _ideal_height;
 			if (!output->bar->config->height &&
 					output->height < _ideal_surface_height) {
+				render_cache_abort(ctx);
 				return _ideal_surface_height;
 			}
 			if (block->separator && sep_width > sep_block_width) {
@@ -342,6 +667,8 @@ static uint32_t render_status_block(struct render_context *ctx,
 			cairo_stroke(cairo);
 		}
 	}
+	render_item_add(ctx, x0, *x, hash);
+	render_cache_end(ctx, hash, x0, *x, output->height);
 	return output->height;
 }
 
@@ -616,6 +943,15 @@ static uint32_t render_binding_mode_indicator(struct render_context *ctx,
 		return 0;
 	}
 
+	uint32_t hash = hash_str(render_item_hash(ctx), mode);
+	hash = hash_u32(hash, output->bar->mode_pango_markup);
+	struct render_cache_entry *cached = render_cache_find(ctx, hash, x, false);
+	if (cached) {
+		render_cache_paint(ctx, cached, x);
+		return cached->height;
+	}
+
+	render_cache_begin(ctx);
 	cairo_t *cairo = ctx->cairo;
 	struct swaybar_config *config = output->bar->config;
 	int text_width, text_height;
@@ -632,6 +968,7 @@ static uint32_t render_binding_mode_indicator(struct render_context *ctx,
 	uint32_t ideal_surface_height = ideal_height;
 	if (!output->bar->config->height &&
 			output->height < ideal_surface_height) {
+		render_cache_abort(ctx);
 		return ideal_surface_height;
 	}
 	uint32_t width = text_width + ws_horizontal_padding * 2 + border_width * 2;
@@ -663,6 +1000,8 @@ static uint32_t render_binding_mode_indicator(struct render_context *ctx,
 	choose_text_aa_mode(ctx, config->colors.binding_mode.text);
 	render_text(cairo, config->font_description, 1, output->bar->mode_pango_markup,
 			"%s", mode);
+	render_item_add(ctx, x, x + width, hash);
+	render_cache_end(ctx, hash, x, x + width, output->height);
 	return output->height;
 }
 
@@ -697,7 +1036,19 @@ static uint32_t render_workspace_button(struct render_context *ctx,
 	}
 
 	uint32_t height = output->height;
+	uint32_t hash = hash_str(render_item_hash(ctx), ws->label);
+	hash = hash_u32(hash, ws->urgent | ws->focused << 1 | ws->visible << 2);
+	struct render_cache_entry *cached = render_cache_find(ctx, hash, *x, false);
+	if (cached) {
+		struct swaybar_hotspot *hotspot = render_cache_paint(ctx, cached, *x);
+		if (hotspot) {
+			hotspot->data = strdup(ws->name);
+		}
+		*x += cached->width;
+		return cached->height;
+	}
 
+	render_cache_begin(ctx);
 	cairo_t *cairo = ctx->cairo;
 	int text_width, text_height;
 	get_text_size(cairo, config->font_description, &text_width, &text_height, NULL,
@@ -712,6 +1063,7 @@ static uint32_t render_workspace_button(struct render_context *ctx,
 	uint32_t ideal_surface_height = ideal_height;
 	if (!output->bar->config->height &&
 			output->height < ideal_surface_height) {
+		render_cache_abort(ctx);
 		return ideal_surface_height;
 	}
 
@@ -754,6 +1106,8 @@ static uint32_t render_workspace_button(struct render_context *ctx,
 	hotspot->data = strdup(ws->name);
 	wl_list_insert(&output->hotspots, &hotspot->link);
 
+	render_item_add(ctx, *x, *x + width, hash);
+	render_cache_end(ctx, hash, *x, *x + width, output->height);
 	*x += width;
 	return output->height;
 }
@@ -761,6 +1115,16 @@ static uint32_t render_workspace_button(struct render_context *ctx,
 static uint32_t render_scroller_item(struct render_context *ctx,
 		double *x, const char *str) {
 	struct swaybar_output *output = ctx->output;
+	uint32_t hash = hash_str(render_item_hash(ctx), str);
+	hash = hash_u32(hash, output->bar->mode_pango_markup);
+	struct render_cache_entry *cached = render_cache_find(ctx, hash, *x, false);
+	if (cached) {
+		render_cache_paint(ctx, cached, *x);
+		*x += cached->width;
+		return cached->height;
+	}
+
+	render_cache_begin(ctx);
 	cairo_t *cairo = ctx->cairo;
 	struct swaybar_config *config = output->bar->config;
 	int text_width, text_height;
@@ -777,6 +1141,7 @@ static uint32_t render_scroller_item(struct render_context *ctx,
 	uint32_t ideal_surface_height = ideal_height;
 	if (!output->bar->config->height &&
 			output->height < ideal_surface_height) {
+		render_cache_abort(ctx);
 		return ideal_surface_height;
 	}
 	uint32_t width = text_width + ws_horizontal_padding * 2 + border_width * 2;
@@ -808,6 +1173,8 @@ static uint32_t render_scroller_item(struct render_context *ctx,
 	choose_text_aa_mode(ctx, config->colors.scroller.text);
 	render_text(cairo, config->font_description, 1, output->bar->mode_pango_markup,
 			"%s", str);
+	render_item_add(ctx, *x, *x + width, hash);
+	render_cache_end(ctx, hash, *x, *x + width, output->height);
 	*x += width;
 	return output->height;
 }
@@ -854,6 +1221,55 @@ static uint32_t render_trails_indicator(struct render_context *ctx,
 	return max_height;
 }
 
+#if HAVE_TRAY
+static uint32_t render_tray_item(struct render_context *ctx,
+		struct swaybar_sni *sni, double *x) {
+	uint32_t hash = hash_str(render_item_hash(ctx), sni->watcher_id);
+	hash = hash_str(hash, sni->status);
+	hash = hash_u32(hash, sni->target_size);
+	hash = hash_u32(hash, sni->icon_serial);
+	double x0 = *x;
+	struct render_cache_entry *cached = render_cache_find(ctx, hash, *x, true);
+	if (cached) {
+		*x -= cached->width;
+		struct swaybar_hotspot *hotspot = render_cache_paint(ctx, cached, *x);
+		if (hotspot) {
+			hotspot->data = strdup(sni->watcher_id);
+		}
+		return cached->height;
+	}
+
+	render_cache_begin(ctx);
+	uint32_t height = render_sni(ctx->cairo, ctx->output, x, sni);
+	render_item_add(ctx, x0, *x, hash);
+	render_cache_end(ctx, hash, x0, *x, height);
+	return height;
+}
+
+static uint32_t render_tray(struct render_context *ctx, double *x) {
+	struct swaybar_output *output = ctx->output;
+	struct swaybar_config *config = output->bar->config;
+	if (!tray_shown_on_output(output)) {
+		return 0;
+	}
+
+	if ((int)(output->height * output->scale) <= 2 * config->tray_padding) {
+		return (2 * config->tray_padding + 1) / output->scale;
+	}
+
+	uint32_t max_height = 0;
+	struct swaybar_tray *tray = output->bar->tray;
+	for (int i = 0; i < tray->items->length; ++i) {
+		uint32_t h = render_tray_item(ctx, tray->items->items[i], x);
+		if (h > max_height) {
+			max_height = h;
+		}
+	}
+
+	return max_height;
+}
+#endif
+
 static uint32_t render_to_cairo(struct render_context *ctx) {
 	cairo_t *cairo = ctx->cairo;
 	struct swaybar_output *output = ctx->output;
@@ -873,7 +1289,7 @@ static uint32_t render_to_cairo(struct render_context *ctx) {
 	double x = output->width;
 #if HAVE_TRAY
 	if (bar->tray) {
-		uint32_t h = render_tray(cairo, output, &x);
+		uint32_t h = render_tray(ctx, &x);
 		max_height = h > max_height ? h : max_height;
 	}
 #endif
@@ -905,6 +1321,63 @@ static uint32_t render_to_cairo(struct render_context *ctx) {
 	return max_height > output->height ? max_height : output->height;
 }
 
+static bool render_item_find(struct wl_array *items, struct render_item *item) {
+	struct render_item *other;
+	wl_array_for_each(other, items) {
+		if (other->hash == item->hash &&
+				other->x0 == item->x0 && other->x1 == item->x1) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void render_damage_add(struct swaybar_output *output,
+		struct wl_array *damage, struct render_item *item) {
+	struct render_item *span = wl_array_add(damage, sizeof(*span));
+	if (!span) {
+		return;
+	}
+	*span = *item;
+	span->x0 = fmax(0, item->x0 - ITEM_DAMAGE_MARGIN);
+	span->x1 = fmin(output->width, item->x1 + ITEM_DAMAGE_MARGIN);
+}
+
+// Adds to damage the spans of the items that were added, removed, moved or
+// changed since the frame in the current buffer. Returns false if the whole
+// bar has to be drawn instead.
+static bool render_damage_items(struct render_context *ctx, uint32_t hash,
+		struct wl_array *damage) {
+	struct swaybar_output *output = ctx->output;
+	if (!output->render_valid || !output->current_buffer ||
+			output->render_hash != hash) {
+		return false;
+	}
+	struct render_item *item;
+	wl_array_for_each(item, &ctx->items) {
+		if (!render_item_find(&output->render_items, item)) {
+			render_damage_add(output, damage, item);
+		}
+	}
+	wl_array_for_each(item, &output->render_items) {
+		if (!render_item_find(&ctx->items, item)) {
+			render_damage_add(output, damage, item);
+		}
+	}
+	return true;
+}
+
+// Everything a frame depends on besides its items
+static uint32_t render_frame_hash(struct swaybar_output *output,
+		uint32_t background_color) {
+	uint32_t hash = hash_u32(2166136261u, output->width);
+	hash = hash_u32(hash, output->height);
+	hash = hash_u32(hash, output->scale);
+	hash = hash_u32(hash, output->subpixel);
+	hash = hash_u32(hash, background_color);
+	return hash_u32(hash, output->bar->config_serial);
+}
+
 static void output_frame_handle_done(void *data, struct wl_callback *callback,
 		uint32_t time) {
 	wl_callback_destroy(callback);
@@ -940,7 +1413,10 @@ void render_frame(struct swaybar_output *output) {
 		// initial background color used for deciding the best way to antialias text
 		.background_color = background_color,
 		.has_transparency = (background_color & 0xFF) != 0xFF,
+		.frame_background = background_color,
+		.frame_hash = render_frame_hash(output, background_color),
 	};
+	wl_array_init(&ctx.items);
 
 	cairo_surface_t *recorder = cairo_recording_surface_create(
 			CAIRO_CONTENT_COLOR_ALPHA, NULL);
@@ -987,29 +1463,77 @@ void render_frame(struct swaybar_output *output) {
 		// different height than what we asked for
 		wl_surface_commit(output->surface);
 	} else if (height > 0) {
+		uint32_t hash = ctx.frame_hash;
+		struct wl_array damage;
+		wl_array_init(&damage);
+		bool partial = render_damage_items(&ctx, hash, &damage);
+		if (partial && damage.size == 0) {
+			// Nothing to redraw
+			wl_array_release(&damage);
+			goto cleanup;
+		}
+
 		// Replay recording into shm and send it off
+		struct pool_buffer *prev = output->current_buffer;
 		output->current_buffer = get_next_buffer(output->bar->shm,
 				output->buffers,
 				output->width * output->scale,
 				output->height * output->scale);
 		if (!output->current_buffer) {
+			wl_array_release(&damage);
 			goto cleanup;
 		}
 		cairo_t *shm = output->current_buffer->cairo;
 
+		if (partial && prev != output->current_buffer) {
+			// Start from the previous frame, only the damaged spans are
+			// rasterized again
+			cairo_save(shm);
+			cairo_set_operator(shm, CAIRO_OPERATOR_SOURCE);
+			cairo_set_source_surface(shm, prev->surface, 0.0, 0.0);
+			cairo_paint(shm);
+			cairo_restore(shm);
+		}
+
 		cairo_save(shm);
+		struct render_item *span;
+		if (partial) {
+			wl_array_for_each(span, &damage) {
+				double x0 = floor(span->x0 * output->scale);
+				double x1 = ceil(span->x1 * output->scale);
+				cairo_rectangle(shm, x0, 0, x1 - x0,
+					output->height * output->scale);
+			}
+			cairo_clip(shm);
+		}
 		cairo_set_operator(shm, CAIRO_OPERATOR_CLEAR);
 		cairo_paint(shm);
-		cairo_restore(shm);
-
+		cairo_set_operator(shm, CAIRO_OPERATOR_OVER);
 		cairo_set_source_surface(shm, recorder, 0.0, 0.0);
 		cairo_paint(shm);
+		cairo_restore(shm);
 
 		wl_surface_set_buffer_scale(output->surface, output->scale);
 		wl_surface_attach(output->surface,
 				output->current_buffer->buffer, 0, 0);
-		wl_surface_damage(output->surface, 0, 0,
-				output->width, output->height);
+		if (partial) {
+			wl_array_for_each(span, &damage) {
+				int x0 = floor(span->x0);
+				wl_surface_damage(output->surface, x0, 0,
+					ceil(span->x1) - x0, output->height);
+			}
+		} else {
+			wl_surface_damage(output->surface, 0, 0,
+					output->width, output->height);
+		}
+		wl_array_release(&damage);
+
+		// Keep the items to compare the next frame with
+		wl_array_release(&output->render_items);
+		output->render_items = ctx.items;
+		wl_array_init(&ctx.items);
+		output->render_hash = hash;
+		output->render_valid = true;
 
 		if (!ctx.has_transparency) {
 			struct wl_region *region =
@@ -1029,6 +1553,8 @@ void render_frame(struct swaybar_output *output) {
 	}
 
 cleanup:
+	render_cache_prune(output);
+	wl_array_release(&ctx.items);
 	if (ctx.textaa_sharp != ctx.textaa_safe) {
 		cairo_font_options_destroy(ctx.textaa_sharp);
 	}
@@ -432,6 +432,7 @@ static void reload_sni(struct swaybar_sni *sni, char *icon_theme,
 		if (icon_path) {
 			cairo_surface_destroy(sni->icon);
 			sni->icon = load_image(icon_path);
+			sni->icon_serial++;
 			free(icon_path);
 			return;
 		}
@@ -454,6 +455,7 @@ static void reload_sni(struct swaybar_sni *sni, char *icon_theme,
 		sni->icon = cairo_image_surface_create_for_data(pixmap->pixels,
 				CAIRO_FORMAT_ARGB32, pixmap->size, pixmap->size,
 				cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, pixmap->size));
+		sni->icon_serial++;
 	}
 }
 
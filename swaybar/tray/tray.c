@@ -116,26 +116,10 @@ static int cmp_output(const void *item, const void *cmp_to) {
 	return strcmp(item, output->name);
 }
 
-uint32_t render_tray(cairo_t *cairo, struct swaybar_output *output, double *x) {
+bool tray_shown_on_output(struct swaybar_output *output) {
 	struct swaybar_config *config = output->bar->config;
 	if (config->tray_outputs) {
-		if (list_seq_find(config->tray_outputs, cmp_output, output) == -1) {
-			return 0;
-		}
-	} // else display on all
-
-	if ((int)(output->height * output->scale) <= 2 * config->tray_padding) {
-		return (2 * config->tray_padding + 1) / output->scale;
+		return list_seq_find(config->tray_outputs, cmp_output, output) != -1;
 	}
-
-	uint32_t max_height = 0;
-	struct swaybar_tray *tray = output->bar->tray;
-	for (int i = 0; i < tray->items->length; ++i) {
-		uint32_t h = render_sni(cairo, output, x, tray->items->items[i]);
-		if (h > max_height) {
-			max_height = h;
-		}
-	}
-
-	return max_height;
+	return true; // display on all
 }
@@ -1,4 +1,5 @@
 
+#include <inttypes.h>
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -445,6 +446,48 @@ static void pretty_print_trails(json_object *i) {
 	printf("\n");
 }
 
+static void pretty_print_histogram(const char *name, json_object *h) {
+	// Times are in nanoseconds
+	printf("  %-22s %8" PRId64 " %10.3f %10.3f %10.3f\n", name,
+		json_object_get_int64(json_object_object_get(h, "count")),
+		json_object_get_int64(json_object_object_get(h, "p50")) / 1000000.0,
+		json_object_get_int64(json_object_object_get(h, "p99")) / 1000000.0,
+		json_object_get_int64(json_object_object_get(h, "max")) / 1000000.0);
+}
+
+static void pretty_print_perf(json_object *p) {
+	static const char *metrics[] = {
+		"frame_cpu", "transaction_latency", "animation_step",
+	};
+
+	printf("Performance:\n");
+	printf("  %-22s %8s %10s %10s %10s\n", "Metric", "Samples",
+		"p50 (ms)", "p99 (ms)", "max (ms)");
+	for (size_t i = 0; i < sizeof(metrics) / sizeof(metrics[0]); ++i) {
+		json_object *h;
+		if (json_object_object_get_ex(p, metrics[i], &h)) {
+			pretty_print_histogram(metrics[i], h);
+		}
+	}
+
+	json_object *outputs = json_object_object_get(p, "outputs");
+	size_t len = json_object_array_length(outputs);
+	for (size_t i = 0; i < len; ++i) {
+		json_object *o = json_object_array_get_idx(outputs, i);
+		printf("\nOutput %s: %" PRId64 " frames, %" PRId64 " missed vblanks\n",
+			json_object_get_string(json_object_object_get(o, "name")),
+			json_object_get_int64(json_object_object_get(o, "frames")),
+			json_object_get_int64(json_object_object_get(o, "missed_vblanks")));
+		pretty_print_histogram("build_state", json_object_object_get(o, "build_state"));
+		pretty_print_histogram("render", json_object_object_get(o, "render"));
+		pretty_print_histogram("present_latency",
+			json_object_object_get(o, "present_latency"));
+	}
+
+	printf("\nTransaction timeouts: %" PRId64 "\n",
+		json_object_get_int64(json_object_object_get(p, "transaction_timeouts")));
+}
+
 static void pretty_print(int type, json_object *resp) {
 	switch (type) {
 	case IPC_SEND_TICK:
@@ -464,6 +507,9 @@ static void pretty_print(int type, json_object *resp) {
 	case IPC_GET_TRAILS:
 		pretty_print_trails(resp);
 		return;
+	case IPC_GET_PERF:
+		pretty_print_perf(resp);
+		return;
 	case IPC_COMMAND:
 	case IPC_GET_WORKSPACES:
 	case IPC_GET_INPUTS:
@@ -618,6 +664,8 @@ int main(int argc, char **argv) {
 		type = IPC_GET_SCROLLER;
 	} else if (strcasecmp(cmdtype, "get_trails") == 0) {
 		type = IPC_GET_TRAILS;
+	} else if (strcasecmp(cmdtype, "get_perf") == 0) {
+		type = IPC_GET_PERF;
 	} else {
 		if (quiet) {
 			exit(EXIT_FAILURE);